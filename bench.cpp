@@ -0,0 +1,656 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bitvec.h"
+#include "eqbool.h"
+
+namespace {
+
+using eqbool::eqbool_context;
+using eqbool::term_set;
+using eqbool::term_table;
+using eqbool::eqbool;
+
+[[noreturn]] static void fatal(std::string msg) {
+    std::cerr << msg << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+enum class output_format { text, csv, json };
+
+struct bench_options {
+    unsigned warmup = 1;
+    unsigned repeat = 100;
+    unsigned max_size = 8;
+
+    // Operations per timed run of microbenchmarks.
+    unsigned count = 10000;
+
+    output_format format = output_format::text;
+};
+
+struct cell {
+    std::string text;
+    bool is_number;
+
+    cell(const char *s) : text(s), is_number(false) {}
+    cell(const std::string &s) : text(s), is_number(false) {}
+    cell(unsigned n) : text(std::to_string(n)), is_number(true) {}
+    cell(unsigned long n) : text(std::to_string(n)), is_number(true) {}
+
+    cell(double d) : is_number(true) {
+        std::ostringstream s;
+        s << d;
+        text = s.str();
+    }
+};
+
+// Prints results as tables, one per benchmark. CSV output has a
+// header line for every table. JSON output is an array of
+// objects, one per row, with the name of the benchmark as the
+// "bench" field.
+class reporter {
+private:
+    output_format format;
+    std::string bench;
+    std::vector<std::string> columns;
+    bool first = true;
+
+public:
+    explicit reporter(output_format format)
+        : format(format) {}
+
+    void begin_table(const std::string &name,
+                     std::vector<std::string> table_columns) {
+        bench = name;
+        columns = std::move(table_columns);
+
+        switch(format) {
+        case output_format::text:
+            std::cout << bench << ":\n";
+            for(std::size_t i = 0; i != columns.size(); ++i)
+                std::cout << (i == 0 ? "" : " ") << columns[i];
+            std::cout << "\n";
+            break;
+        case output_format::csv:
+            if(!first)
+                std::cout << "\n";
+            std::cout << "bench";
+            for(const std::string &c : columns)
+                std::cout << "," << c;
+            std::cout << "\n";
+            break;
+        case output_format::json:
+            // Opened with the first row.
+            return;
+        }
+        first = false;
+    }
+
+    void add_row(const std::vector<cell> &cells) {
+        assert(cells.size() == columns.size());
+        switch(format) {
+        case output_format::text:
+            for(std::size_t i = 0; i != cells.size(); ++i)
+                std::cout << (i == 0 ? "" : " ") << cells[i].text;
+            std::cout << "\n";
+            break;
+        case output_format::csv:
+            std::cout << bench;
+            for(const cell &c : cells)
+                std::cout << "," << c.text;
+            std::cout << "\n";
+            break;
+        case output_format::json:
+            std::cout << (first ? "[\n" : ",\n") <<
+                         "  {\"bench\": \"" << bench << "\"";
+            for(std::size_t i = 0; i != cells.size(); ++i) {
+                std::cout << ", \"" << columns[i] << "\": ";
+                if(cells[i].is_number)
+                    std::cout << cells[i].text;
+                else
+                    std::cout << "\"" << cells[i].text << "\"";
+            }
+            std::cout << "}";
+            break;
+        }
+        first = false;
+    }
+
+    void finish() {
+        if(format == output_format::json)
+            std::cout << (first ? "[]\n" : "\n]\n");
+    }
+};
+
+// Calls the run function for the warm-up runs and then for the
+// timed ones, passing it the time to accumulate the timed part of
+// the run in. Returns the average time per operation in
+// nanoseconds.
+template<typename F>
+static double measure(const bench_options &opts, unsigned long num_ops,
+                      F run) {
+    double time = 0, warmup_time = 0;
+    for(unsigned r = 0; r != opts.warmup + opts.repeat; ++r)
+        run(r < opts.warmup ? warmup_time : time);
+    return time / opts.repeat / static_cast<double>(num_ops) * 1e9;
+}
+
+class bench_context {
+private:
+    term_table terms;
+
+public:
+    eqbool_context eqbools{terms};
+
+    std::vector<eqbool> get_word(const std::string &name, unsigned width) {
+        std::vector<eqbool> word;
+        for(unsigned i = 0; i != width; ++i)
+            word.push_back(eqbools.get(terms.add(name + std::to_string(i))));
+        return word;
+    }
+
+    std::vector<eqbool> add(const std::vector<eqbool> &a,
+                            const std::vector<eqbool> &b) {
+        std::vector<eqbool> sum;
+        eqbool carry = eqbools.get_false();
+        for(std::size_t i = 0; i != a.size(); ++i) {
+            sum.push_back(eqbools.get_eq(eqbools.get_eq(a[i], b[i]), carry));
+            carry = (a[i] & b[i]) | (carry & (a[i] | b[i]));
+        }
+        return sum;
+    }
+};
+
+// Times is_unsat() on the miters of (a + b) + c and a + (b + c)
+// of growing widths with both the built-in solver and CaDiCaL to
+// find out the number of clauses at which the latter starts to
+// pay off.
+static void bench_sat_crossover(const bench_options &opts, reporter &r) {
+    r.begin_table("sat-crossover",
+                  {"width", "clauses", "small-us", "cadical-us"});
+    for(unsigned width = 1; width <= opts.max_size; ++width) {
+        bench_context c;
+        std::vector<eqbool> a = c.get_word("a", width);
+        std::vector<eqbool> b = c.get_word("b", width);
+        std::vector<eqbool> d = c.get_word("c", width);
+        std::vector<eqbool> x = c.add(c.add(a, b), d);
+        std::vector<eqbool> y = c.add(a, c.add(b, d));
+
+        std::vector<eqbool> miters;
+        for(unsigned i = 0; i != width; ++i) {
+            eqbool m = ~c.eqbools.get_eq(x[i], y[i]);
+            if(!m.is_const())
+                miters.push_back(m);
+        }
+        if(miters.empty())
+            continue;
+
+        double times[2] = {};
+        unsigned long clauses = 0;
+        for(unsigned small = 0; small != 2; ++small) {
+            c.eqbools.set_small_sat_threshold(small ? ~0ul : 0);
+            unsigned long num_clauses = c.eqbools.get_stats().num_clauses;
+            ::eqbool::timer t(times[small]);
+            for(unsigned n = 0; n != opts.repeat; ++n) {
+                for(eqbool m : miters) {
+                    if(!c.eqbools.is_unsat(m))
+                        fatal("adders are expected to be associative");
+                }
+            }
+            clauses = c.eqbools.get_stats().num_clauses - num_clauses;
+        }
+
+        double num_queries = static_cast<double>(opts.repeat * miters.size());
+        r.add_row({width, clauses / (opts.repeat * miters.size()),
+                   times[1] / num_queries * 1e6,
+                   times[0] / num_queries * 1e6});
+    }
+}
+
+// Builds the XOR of the edges of a random 4-regular graph, which is
+// constant as every vertex appears an even number of times, and
+// times proving that with and without the XOR reasoning. Such
+// parity constraints take exponential time to refute by resolution.
+static void bench_parity(const bench_options &opts, reporter &r) {
+    r.begin_table("parity", {"vertices", "clauses", "xor-us", "no-xor-us"});
+    std::minstd_rand rng;
+    for(unsigned n = 4; n <= opts.max_size * 2; n += 2) {
+        bench_context c;
+        std::vector<eqbool> v = c.get_word("v", n);
+
+        // Two random Hamiltonian cycles give every vertex the
+        // degree of four.
+        std::vector<std::pair<unsigned, unsigned>> edges;
+        for(unsigned k = 0; k != 2; ++k) {
+            std::vector<unsigned> order;
+            for(unsigned i = 0; i != n; ++i)
+                order.push_back(i);
+            std::shuffle(order.begin(), order.end(), rng);
+            for(unsigned i = 0; i != n; ++i)
+                edges.push_back({order[i], order[(i + 1) % n]});
+        }
+        std::shuffle(edges.begin(), edges.end(), rng);
+
+        eqbool x = c.eqbools.get_false();
+        for(const auto &edge : edges)
+            x = ~c.eqbools.get_eq(x, ~c.eqbools.get_eq(v[edge.first],
+                                                       v[edge.second]));
+        if(x.is_const())
+            continue;
+
+        double times[2] = {};
+        unsigned long clauses = 0;
+        for(unsigned use_xors = 0; use_xors != 2; ++use_xors) {
+            c.eqbools.set_xor_reasoning(use_xors);
+            unsigned long num_clauses = c.eqbools.get_stats().num_clauses;
+            ::eqbool::timer t(times[use_xors]);
+            for(unsigned i = 0; i != opts.repeat; ++i) {
+                if(!c.eqbools.is_unsat(x))
+                    fatal("parity of an even graph is expected to be 0");
+            }
+            clauses = c.eqbools.get_stats().num_clauses - num_clauses;
+        }
+
+        r.add_row({n, clauses / opts.repeat, times[1] / opts.repeat * 1e6,
+                   times[0] / opts.repeat * 1e6});
+    }
+}
+
+// Builds (a + b) + c and a + (b + c) with each of the adder
+// structures and times the construction and then proving the sums
+// equal.
+static void bench_adders(const bench_options &opts, reporter &r) {
+    using ::eqbool::adder_kind;
+    using ::eqbool::bitvec_context;
+    using ::eqbool::word;
+
+    const struct {
+        const char *name;
+        adder_kind kind;
+    } adders[] = {
+        {"ripple", adder_kind::ripple},
+        {"lookahead", adder_kind::lookahead},
+    };
+
+    r.begin_table("adders",
+                  {"width", "adder", "clauses", "build-us", "sat-us"});
+    for(unsigned width = 1; width <= opts.max_size; ++width) {
+        // Make sure the structures agree.
+        {
+            bench_context c;
+            bitvec_context bv(c.eqbools);
+            word a = c.get_word("a", width);
+            word b = c.get_word("b", width);
+            bv.set_adder_kind(adder_kind::ripple);
+            word x = bv.add(a, b);
+            bv.set_adder_kind(adder_kind::lookahead);
+            word y = bv.add(a, b);
+            for(unsigned i = 0; i != width; ++i) {
+                if(!c.eqbools.is_equiv(x[i], y[i]))
+                    fatal("adder structures disagree");
+            }
+        }
+
+        for(const auto &adder : adders) {
+            double times[2] = {};
+            unsigned long clauses = 0;
+            for(unsigned n = 0; n != opts.repeat; ++n) {
+                bench_context c;
+                bitvec_context bv(c.eqbools);
+                bv.set_adder_kind(adder.kind);
+                word a = c.get_word("a", width);
+                word b = c.get_word("b", width);
+                word d = c.get_word("c", width);
+
+                word x, y;
+                {
+                    ::eqbool::timer t(times[0]);
+                    x = bv.add(bv.add(a, b), d);
+                    y = bv.add(a, bv.add(b, d));
+                }
+
+                {
+                    ::eqbool::timer t(times[1]);
+                    for(unsigned i = 0; i != width; ++i) {
+                        if(!c.eqbools.is_equiv(x[i], y[i]))
+                            fatal("adders are expected to be associative");
+                    }
+                }
+                clauses += c.eqbools.get_stats().num_clauses;
+            }
+
+            r.add_row({width, adder.name, clauses / opts.repeat,
+                       times[0] / opts.repeat * 1e6,
+                       times[1] / opts.repeat * 1e6});
+        }
+    }
+}
+
+// Adds terms to term sets and gets their nodes, both the ones new
+// to the context and the ones already there.
+template<typename T>
+static void time_terms(const bench_options &opts, reporter &r,
+                       const char *set_name) {
+    std::vector<std::string> names;
+    for(unsigned i = 0; i != opts.count; ++i)
+        names.push_back("t" + std::to_string(i));
+
+    double add_ns = measure(opts, opts.count, [&](double &time) {
+        T terms;
+        ::eqbool::timer t(time);
+        for(const std::string &name : names)
+            terms.add(name);
+    });
+
+    double new_ns = measure(opts, opts.count, [&](double &time) {
+        T terms;
+        std::vector<uintptr_t> codes;
+        for(const std::string &name : names)
+            codes.push_back(terms.add(name));
+        eqbool_context eqbools(terms);
+        ::eqbool::timer t(time);
+        for(uintptr_t code : codes)
+            eqbools.get(code);
+    });
+
+    T terms;
+    std::vector<uintptr_t> codes;
+    for(const std::string &name : names)
+        codes.push_back(terms.add(name));
+    eqbool_context eqbools(terms);
+    for(uintptr_t code : codes)
+        eqbools.get(code);
+    double existing_ns = measure(opts, opts.count, [&](double &time) {
+        ::eqbool::timer t(time);
+        for(uintptr_t code : codes)
+            eqbools.get(code);
+    });
+
+    r.add_row({opts.count, set_name, "add", add_ns});
+    r.add_row({opts.count, set_name, "get-new", new_ns});
+    r.add_row({opts.count, set_name, "get-existing", existing_ns});
+}
+
+static void bench_get(const bench_options &opts, reporter &r) {
+    r.begin_table("get", {"terms", "set", "op", "ns"});
+    time_terms<term_set<std::string>>(opts, r, "set");
+    time_terms<term_table>(opts, r, "table");
+}
+
+// Builds disjunctions of random literals of twice as many terms
+// as the disjunctions have arguments.
+static void bench_or(const bench_options &opts, reporter &r) {
+    r.begin_table("or", {"width", "ops", "ns"});
+    unsigned max_width = 1u << std::min(opts.max_size, 16u);
+    for(unsigned width = 2; width <= max_width; width *= 2) {
+        unsigned num_ops = std::max(opts.count / width, 1u);
+        double ns = measure(opts, num_ops, [&](double &time) {
+            bench_context c;
+            std::vector<eqbool> v = c.get_word("v", width * 2);
+            std::minstd_rand rng;
+            std::vector<std::vector<eqbool>> args(num_ops);
+            for(std::vector<eqbool> &a : args) {
+                for(unsigned i = 0; i != width; ++i) {
+                    eqbool t = v[rng() % v.size()];
+                    a.push_back(t ^ ((rng() & 1) != 0));
+                }
+            }
+
+            ::eqbool::timer t(time);
+            for(const std::vector<eqbool> &a : args)
+                c.eqbools.get_or(a);
+        });
+        r.add_row({width, num_ops, ns});
+    }
+}
+
+// Grows a random DAG of nodes of the specified arity on top of a
+// set of terms, every new node taking its arguments from the nodes
+// built so far.
+template<typename F>
+static double time_dag(const bench_options &opts, unsigned arity, F build) {
+    const unsigned num_terms = 64;
+    return measure(opts, opts.count, [&](double &time) {
+        bench_context c;
+        std::vector<eqbool> nodes = c.get_word("v", num_terms);
+        std::minstd_rand rng;
+        std::vector<std::size_t> picks;
+        for(unsigned i = 0; i != opts.count; ++i) {
+            for(unsigned k = 0; k != arity; ++k) {
+                std::size_t pick = rng() % (num_terms + i);
+                picks.push_back(pick * 2 + (rng() & 1));
+            }
+        }
+
+        ::eqbool::timer t(time);
+        const std::size_t *p = picks.data();
+        for(unsigned i = 0; i != opts.count; ++i, p += arity) {
+            eqbool args[3];
+            for(unsigned k = 0; k != arity; ++k)
+                args[k] = nodes[p[k] / 2] ^ ((p[k] & 1) != 0);
+            nodes.push_back(build(c.eqbools, args));
+        }
+    });
+}
+
+static void bench_ifelse(const bench_options &opts, reporter &r) {
+    r.begin_table("ifelse", {"nodes", "ns"});
+    r.add_row({opts.count, time_dag(opts, 3,
+        [](eqbool_context &c, const eqbool *args) {
+            return c.ifelse(args[0], args[1], args[2]); })});
+}
+
+static void bench_eq(const bench_options &opts, reporter &r) {
+    r.begin_table("eq", {"nodes", "ns"});
+    r.add_row({opts.count, time_dag(opts, 2,
+        [](eqbool_context &c, const eqbool *args) {
+            return c.get_eq(args[0], args[1]); })});
+}
+
+// Builds carries of full adders with their arguments in different
+// orders, so that proving them equal takes the SAT solver.
+static void get_carries(bench_context &c, unsigned n,
+                        std::vector<eqbool> &x, std::vector<eqbool> &y) {
+    std::vector<eqbool> a = c.get_word("a", n);
+    std::vector<eqbool> b = c.get_word("b", n);
+    std::vector<eqbool> d = c.get_word("d", n);
+    for(unsigned i = 0; i != n; ++i) {
+        x.push_back((a[i] & b[i]) | (d[i] & (a[i] | b[i])));
+        y.push_back((b[i] & d[i]) | (a[i] & (b[i] | d[i])));
+    }
+}
+
+// Propagates nodes that are canonical and nodes whose arguments
+// have been merged with other nodes since they were built.
+static void bench_propagate(const bench_options &opts, reporter &r) {
+    r.begin_table("propagate", {"nodes", "kind", "ns"});
+    unsigned n = std::max(opts.count / 100, 1u);
+    bench_context c;
+    std::vector<eqbool> x, y;
+    get_carries(c, n, x, y);
+    std::vector<eqbool> e = c.get_word("e", n);
+    std::vector<eqbool> stale, canonical;
+    for(unsigned i = 0; i != n; ++i) {
+        stale.push_back(y[i] | e[i]);
+        if(!c.eqbools.is_equiv(x[i], y[i]))
+            fatal("carries are expected to be equal");
+        canonical.push_back(x[i] | e[i]);
+    }
+
+    const struct {
+        const char *kind;
+        const std::vector<eqbool> &nodes;
+    } sets[] = {
+        {"canonical", canonical},
+        {"stale", stale},
+    };
+
+    for(const auto &set : sets) {
+        double ns = measure(opts, n, [&](double &time) {
+            ::eqbool::timer t(time);
+            for(eqbool p : set.nodes)
+                p.propagate();
+        });
+        r.add_row({n, set.kind, ns});
+    }
+}
+
+// Prints a DAG of IFELSE nodes with shared subexpressions.
+static void bench_print(const bench_options &opts, reporter &r) {
+    r.begin_table("print", {"nodes", "chars", "ns"});
+    bench_context c;
+    std::vector<eqbool> v = c.get_word("v", 64);
+    std::minstd_rand rng;
+    eqbool x = v[0], y = v[1];
+    for(unsigned i = 0; i != opts.count; ++i) {
+        eqbool z = c.eqbools.ifelse(v[rng() % v.size()], x, ~y);
+        y = x;
+        x = z;
+    }
+
+    std::size_t num_chars = 0;
+    double ns = measure(opts, opts.count, [&](double &time) {
+        std::ostringstream s;
+        {
+            ::eqbool::timer t(time);
+            s << x;
+        }
+        num_chars = s.str().size();
+    });
+    r.add_row({opts.count, num_chars, ns});
+}
+
+// Checks nodes that are equivalent by construction and nodes the
+// equivalence of which takes the SAT solver.
+static void bench_equiv(const bench_options &opts, reporter &r) {
+    r.begin_table("equiv", {"queries", "kind", "ns"});
+
+    double trivial_ns = measure(opts, opts.count, [&](double &time) {
+        bench_context c;
+        std::vector<eqbool> a = c.get_word("a", opts.count);
+        std::vector<eqbool> b = c.get_word("b", opts.count);
+        std::vector<eqbool> x, y;
+        for(unsigned i = 0; i != opts.count; ++i) {
+            x.push_back(a[i] & ~b[i]);
+            y.push_back(~(~a[i] | b[i]));
+        }
+
+        ::eqbool::timer t(time);
+        for(unsigned i = 0; i != opts.count; ++i) {
+            if(!c.eqbools.is_equiv(x[i], y[i]))
+                fatal("nodes are expected to be equal");
+        }
+    });
+    r.add_row({opts.count, "trivial", trivial_ns});
+
+    unsigned n = std::max(opts.count / 100, 1u);
+    double sat_ns = measure(opts, n, [&](double &time) {
+        bench_context c;
+        std::vector<eqbool> x, y;
+        get_carries(c, n, x, y);
+
+        ::eqbool::timer t(time);
+        for(unsigned i = 0; i != n; ++i) {
+            if(!c.eqbools.is_equiv(x[i], y[i]))
+                fatal("carries are expected to be equal");
+        }
+    });
+    r.add_row({n, "sat", sat_ns});
+}
+
+}  // anonymous namespace
+
+int main(int argc, const char **argv) {
+    (void) argc;  // Unused.
+
+    bench_options opts;
+    std::vector<std::string> names;
+    for(int i = 1; argv[i]; ++i) {
+        std::string arg = argv[i];
+        if(arg[0] != '-') {
+            names.push_back(arg);
+            continue;
+        }
+        if(arg == "--warmup" && argv[i + 1]) {
+            opts.warmup = static_cast<unsigned>(std::atoi(argv[++i]));
+            continue;
+        }
+        if(arg == "--repeat" && argv[i + 1]) {
+            opts.repeat = static_cast<unsigned>(std::atoi(argv[++i]));
+            continue;
+        }
+        if(arg == "--max-size" && argv[i + 1]) {
+            opts.max_size = static_cast<unsigned>(std::atoi(argv[++i]));
+            continue;
+        }
+        if(arg == "--count" && argv[i + 1]) {
+            opts.count = static_cast<unsigned>(std::atoi(argv[++i]));
+            continue;
+        }
+        if(arg == "--format" && argv[i + 1]) {
+            std::string format = argv[++i];
+            if(format == "text")
+                opts.format = output_format::text;
+            else if(format == "csv")
+                opts.format = output_format::csv;
+            else if(format == "json")
+                opts.format = output_format::json;
+            else
+                fatal("unknown output format '" + format + "'");
+            continue;
+        }
+        fatal("unknown option '" + arg + "'");
+    }
+
+    if(opts.repeat == 0 || opts.count == 0)
+        fatal("the numbers of repetitions and operations have to be positive");
+
+    struct bench {
+        const char *name;
+        void (*run)(const bench_options &opts, reporter &r);
+    };
+
+    const bench benches[] = {
+        {"get", bench_get},
+        {"or", bench_or},
+        {"ifelse", bench_ifelse},
+        {"eq", bench_eq},
+        {"propagate", bench_propagate},
+        {"print", bench_print},
+        {"equiv", bench_equiv},
+        {"sat-crossover", bench_sat_crossover},
+        {"parity", bench_parity},
+        {"adders", bench_adders},
+    };
+
+    for(const std::string &name : names) {
+        auto is_named = [&](const bench &b) { return name == b.name; };
+        if(std::none_of(std::begin(benches), std::end(benches), is_named))
+            fatal("unknown benchmark '" + name + "'");
+    }
+
+    reporter r(opts.format);
+    for(const bench &b : benches) {
+        if(names.empty() || std::find(names.begin(), names.end(),
+                                      b.name) != names.end())
+            b.run(opts, r);
+    }
+    r.finish();
+}
@@ -0,0 +1,287 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#include "bitvec.h"
+
+namespace eqbool {
+
+namespace {
+
+bool can_fold(const word &a, const word &b) {
+    return a.size() <= 64 && bitvec_context::is_const(a) &&
+           bitvec_context::is_const(b);
+}
+
+std::uint64_t get_mask(std::size_t width) {
+    return width < 64 ? (std::uint64_t(1) << width) - 1 : ~std::uint64_t(0);
+}
+
+}  // anonymous namespace
+
+word bitvec_context::get(std::uint64_t value, unsigned width) {
+    word w;
+    w.reserve(width);
+    for(unsigned i = 0; i != width; ++i)
+        w.push_back(context.get(i < 64 && ((value >> i) & 1)));
+    return w;
+}
+
+word bitvec_context::get(const std::vector<uintptr_t> &terms) {
+    word w;
+    w.reserve(terms.size());
+    for(uintptr_t t : terms)
+        w.push_back(context.get(t));
+    return w;
+}
+
+bool bitvec_context::is_const(const word &w) {
+    for(eqbool b : w) {
+        if(!b.is_const())
+            return false;
+    }
+    return true;
+}
+
+std::uint64_t bitvec_context::get_value(const word &w) {
+    assert(w.size() <= 64 && is_const(w));
+    std::uint64_t value = 0;
+    for(std::size_t i = 0; i != w.size(); ++i)
+        value |= static_cast<std::uint64_t>(w[i].is_true()) << i;
+    return value;
+}
+
+word bitvec_context::get_not(const word &a) {
+    word r;
+    r.reserve(a.size());
+    for(eqbool b : a)
+        r.push_back(~b);
+    return r;
+}
+
+word bitvec_context::get_and(const word &a, const word &b) {
+    assert(a.size() == b.size());
+    word r;
+    r.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        r.push_back(context.get_and(a[i], b[i]));
+    return r;
+}
+
+word bitvec_context::get_or(const word &a, const word &b) {
+    assert(a.size() == b.size());
+    word r;
+    r.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        r.push_back(context.get_or({a[i], b[i]}));
+    return r;
+}
+
+word bitvec_context::get_xor(const word &a, const word &b) {
+    assert(a.size() == b.size());
+    word r;
+    r.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        r.push_back(~context.get_eq(a[i], b[i]));
+    return r;
+}
+
+word bitvec_context::add_ripple(const word &a, const word &b,
+                                eqbool &carry) {
+    word sum;
+    sum.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i) {
+        eqbool p = ~context.get_eq(a[i], b[i]);
+        sum.push_back(~context.get_eq(p, carry));
+        carry = context.ifelse(p, carry, a[i]);
+    }
+    return sum;
+}
+
+// Kogge-Stone parallel prefix adder.
+word bitvec_context::add_lookahead(const word &a, const word &b,
+                                   eqbool &carry) {
+    std::size_t width = a.size();
+    word g, p;
+    g.reserve(width);
+    p.reserve(width);
+    for(std::size_t i = 0; i != width; ++i) {
+        g.push_back(context.get_and(a[i], b[i]));
+        p.push_back(~context.get_eq(a[i], b[i]));
+    }
+
+    // Generate and propagate signals for the prefixes [0, i].
+    word pg = g, pp = p;
+    for(std::size_t d = 1; d < width; d *= 2) {
+        for(std::size_t i = width; i-- > d;) {
+            pg[i] = context.get_or({pg[i], context.get_and(pp[i], pg[i - d])});
+            pp[i] = context.get_and(pp[i], pp[i - d]);
+        }
+    }
+
+    word sum;
+    sum.reserve(width);
+    eqbool carry_in = carry;
+    for(std::size_t i = 0; i != width; ++i) {
+        sum.push_back(~context.get_eq(p[i], carry));
+        carry = context.get_or({pg[i], context.get_and(pp[i], carry_in)});
+    }
+    return sum;
+}
+
+word bitvec_context::add(const word &a, const word &b, eqbool &carry) {
+    assert(a.size() == b.size());
+
+    if(carry.is_const() && can_fold(a, b)) {
+        std::uint64_t x = get_value(a);
+        std::uint64_t c = carry.is_true();
+        std::uint64_t s = x + get_value(b) + c;
+        std::size_t width = a.size();
+        if(width < 64)
+            carry = context.get(((s >> width) & 1) != 0);
+        else
+            carry = context.get(c ? s <= x : s < x);
+        return get(s & get_mask(width), static_cast<unsigned>(width));
+    }
+
+    switch(adder) {
+    case adder_kind::ripple:
+        return add_ripple(a, b, carry);
+    case adder_kind::lookahead:
+        return add_lookahead(a, b, carry);
+    }
+    unreachable("unknown adder kind");
+}
+
+word bitvec_context::add(const word &a, const word &b) {
+    eqbool carry = context.get_false();
+    return add(a, b, carry);
+}
+
+word bitvec_context::sub(const word &a, const word &b, eqbool &borrow) {
+    // a - b - borrow = a + ~b + ~borrow
+    eqbool carry = ~borrow;
+    word diff = add(a, get_not(b), carry);
+    borrow = ~carry;
+    return diff;
+}
+
+word bitvec_context::sub(const word &a, const word &b) {
+    eqbool borrow = context.get_false();
+    return sub(a, b, borrow);
+}
+
+eqbool bitvec_context::is_eq(const word &a, const word &b) {
+    assert(a.size() == b.size());
+    if(can_fold(a, b))
+        return context.get(get_value(a) == get_value(b));
+
+    std::vector<eqbool> eqs;
+    eqs.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        eqs.push_back(context.get_eq(a[i], b[i]));
+    return context.get_and(eqs);
+}
+
+eqbool bitvec_context::is_ult(const word &a, const word &b) {
+    assert(a.size() == b.size());
+    if(can_fold(a, b))
+        return context.get(get_value(a) < get_value(b));
+
+    // The most significant differing bit decides.
+    eqbool lt = context.get_false();
+    for(std::size_t i = 0; i != a.size(); ++i)
+        lt = context.ifelse(context.get_eq(a[i], b[i]), lt, b[i]);
+    return lt;
+}
+
+eqbool bitvec_context::is_slt(const word &a, const word &b) {
+    assert(a.size() == b.size());
+    if(a.empty())
+        return context.get_false();
+
+    // Flipping the sign bits maps signed order to unsigned.
+    word x = a, y = b;
+    x.back() = ~x.back();
+    y.back() = ~y.back();
+    return is_ult(x, y);
+}
+
+word bitvec_context::shl(const word &a, unsigned n) {
+    word r;
+    r.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        r.push_back(i >= n ? a[i - n] : context.get_false());
+    return r;
+}
+
+word bitvec_context::lshr(const word &a, unsigned n) {
+    word r;
+    r.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        r.push_back(n < a.size() - i ? a[i + n] : context.get_false());
+    return r;
+}
+
+word bitvec_context::ashr(const word &a, unsigned n) {
+    if(a.empty())
+        return a;
+
+    word r;
+    r.reserve(a.size());
+    for(std::size_t i = 0; i != a.size(); ++i)
+        r.push_back(n < a.size() - i ? a[i + n] : a.back());
+    return r;
+}
+
+word bitvec_context::shl(const word &a, const word &n) {
+    if(n.size() <= 64 && is_const(n)) {
+        std::uint64_t v = get_value(n);
+        return shl(a, v < a.size() ? static_cast<unsigned>(v) :
+                                     static_cast<unsigned>(a.size()));
+    }
+
+    word r = a;
+    for(std::size_t k = 0; k != n.size(); ++k) {
+        unsigned amount = k < 32 && (std::size_t(1) << k) < a.size() ?
+            1u << k : static_cast<unsigned>(a.size());
+        r = ifelse(n[k], shl(r, amount), r);
+    }
+    return r;
+}
+
+word bitvec_context::lshr(const word &a, const word &n) {
+    if(n.size() <= 64 && is_const(n)) {
+        std::uint64_t v = get_value(n);
+        return lshr(a, v < a.size() ? static_cast<unsigned>(v) :
+                                      static_cast<unsigned>(a.size()));
+    }
+
+    word r = a;
+    for(std::size_t k = 0; k != n.size(); ++k) {
+        unsigned amount = k < 32 && (std::size_t(1) << k) < a.size() ?
+            1u << k : static_cast<unsigned>(a.size());
+        r = ifelse(n[k], lshr(r, amount), r);
+    }
+    return r;
+}
+
+word bitvec_context::ifelse(eqbool i, const word &t, const word &e) {
+    assert(t.size() == e.size());
+    if(i.is_const())
+        return i.is_true() ? t : e;
+
+    word r;
+    r.reserve(t.size());
+    for(std::size_t k = 0; k != t.size(); ++k)
+        r.push_back(context.ifelse(i, t[k], e[k]));
+    return r;
+}
+
+}  // namespace eqbool
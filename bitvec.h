@@ -0,0 +1,82 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#ifndef EQBOOL_BITVEC_H
+#define EQBOOL_BITVEC_H
+
+#include <vector>
+
+#include "eqbool.h"
+
+namespace eqbool {
+
+// Words are vectors of bits, least significant first.
+using word = std::vector<eqbool>;
+
+enum class adder_kind { ripple, lookahead };
+
+// Word-level operations. Words whose bits are all constant are
+// folded as whole words rather than bit by bit.
+class bitvec_context {
+private:
+    eqbool_context &context;
+    adder_kind adder = adder_kind::ripple;
+
+    word add_ripple(const word &a, const word &b, eqbool &carry);
+    word add_lookahead(const word &a, const word &b, eqbool &carry);
+
+public:
+    explicit bitvec_context(eqbool_context &context)
+        : context(context) {}
+
+    eqbool_context &get_context() const { return context; }
+
+    adder_kind get_adder_kind() const { return adder; }
+    void set_adder_kind(adder_kind kind) { adder = kind; }
+
+    word get(std::uint64_t value, unsigned width);
+    word get(const std::vector<uintptr_t> &terms);
+
+    static bool is_const(const word &w);
+
+    // The word has to be constant and not wider than 64 bits.
+    static std::uint64_t get_value(const word &w);
+
+    word get_not(const word &a);
+    word get_and(const word &a, const word &b);
+    word get_or(const word &a, const word &b);
+    word get_xor(const word &a, const word &b);
+
+    // Sets the carry to the carry out.
+    word add(const word &a, const word &b, eqbool &carry);
+    word add(const word &a, const word &b);
+
+    // Sets the borrow to the borrow out.
+    word sub(const word &a, const word &b, eqbool &borrow);
+    word sub(const word &a, const word &b);
+
+    eqbool is_eq(const word &a, const word &b);
+    eqbool is_ult(const word &a, const word &b);
+    eqbool is_slt(const word &a, const word &b);
+
+    word shl(const word &a, unsigned n);
+    word lshr(const word &a, unsigned n);
+    word ashr(const word &a, unsigned n);
+
+    // Shifts by a variable amount using a barrel shifter.
+    word shl(const word &a, const word &n);
+    word lshr(const word &a, const word &n);
+
+    word ifelse(eqbool i, const word &t, const word &e);
+};
+
+}  // namespace eqbool
+
+#endif
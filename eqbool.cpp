@@ -9,8 +9,19 @@
 */
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
 #include <ctime>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
 
 #pragma GCC diagnostic push
@@ -23,10 +34,68 @@
 #pragma GCC diagnostic pop
 
 #include "eqbool.h"
+#include "recorder.h"
 
 namespace eqbool {
 
 using detail::node_def;
+using detail::sat_job;
+
+bool cnf::read_dimacs(std::istream &s) {
+    *this = cnf();
+
+    unsigned long expected_num_clauses = 0;
+    bool has_header = false;
+    std::string line;
+    while(std::getline(s, line)) {
+        if(line.empty() || line[0] == 'c')
+            continue;
+
+        std::istringstream ls(line);
+        if(line[0] == 'p') {
+            std::string p, format;
+            int expected_num_vars;
+            if(has_header ||
+                   !(ls >> p >> format >> expected_num_vars >>
+                         expected_num_clauses) ||
+                   format != "cnf")
+                return false;
+            has_header = true;
+            continue;
+        }
+
+        if(!has_header)
+            return false;
+
+        int lit;
+        while(ls >> lit)
+            add(lit);
+        if(!ls.eof())
+            return false;
+    }
+
+    return has_header && num_clauses == expected_num_clauses &&
+           (lits.empty() || lits.back() == 0);
+}
+
+std::ostream &cnf::write_dimacs(std::ostream &s) const {
+    s << "p cnf " << num_vars << " " << num_clauses << "\n";
+    const char *sep = "";
+    for(int lit : lits) {
+        s << sep << lit;
+        sep = lit == 0 ? "\n" : " ";
+    }
+    return s << sep;
+}
+
+// The state of the solver used for queries under assumptions. The
+// nodes are encoded once and then reused by all further queries.
+struct detail::sat_session {
+    CaDiCaL::Solver solver;
+    std::unordered_map<const node_def*, int> literals;
+    std::unordered_set<const node_def*> visited;
+    unsigned long num_clauses = 0;
+};
 
 namespace {
 
@@ -35,8 +104,425 @@ bool contains(const C &c, const E &e) {
     return std::find(c.begin(), c.end(), e) != c.end();
 }
 
+// A minimal CDCL solver for queries small enough for the cost of
+// setting up a CaDiCaL instance to dominate the solving time. No
+// restarts, no clause deletion, no options.
+class small_solver {
+private:
+    static constexpr unsigned no_clause = ~0u;
+
+    // Literals are encoded as 2 * var + sign, so that zero can
+    // terminate clauses.
+    std::vector<unsigned> lits;
+    std::vector<std::vector<unsigned>> watches;
+    std::vector<signed char> values;
+    std::vector<unsigned> levels;
+    std::vector<unsigned> reasons;
+    std::vector<double> activity;
+    std::vector<char> seen;
+    std::vector<unsigned> trail;
+    std::vector<std::size_t> trail_lims;
+    std::size_t num_propagated = 0;
+    double activity_inc = 1;
+    bool empty_clause = false;
+
+    static unsigned get_var(unsigned lit) { return lit >> 1; }
+
+    signed char get_value(unsigned lit) const { return values[lit]; }
+
+    unsigned get_level() const {
+        return static_cast<unsigned>(trail_lims.size());
+    }
+
+    void assign(unsigned lit, unsigned reason) {
+        values[lit] = 1;
+        values[lit ^ 1] = -1;
+        levels[get_var(lit)] = get_level();
+        reasons[get_var(lit)] = reason;
+        trail.push_back(lit);
+    }
+
+    void watch(unsigned c) {
+        watches[lits[c]].push_back(c);
+        watches[lits[c + 1]].push_back(c);
+    }
+
+    // Returns the conflicting clause, if any.
+    unsigned propagate() {
+        while(num_propagated != trail.size()) {
+            unsigned falsified = trail[num_propagated++] ^ 1;
+            std::vector<unsigned> &ws = watches[falsified];
+            std::size_t j = 0;
+            for(std::size_t i = 0; i != ws.size(); ++i) {
+                unsigned c = ws[i];
+                unsigned *cl = &lits[c];
+                if(cl[0] == falsified)
+                    std::swap(cl[0], cl[1]);
+
+                if(get_value(cl[0]) > 0) {
+                    ws[j++] = c;
+                    continue;
+                }
+
+                unsigned *k = cl + 2;
+                while(*k && get_value(*k) < 0)
+                    ++k;
+                if(*k) {
+                    std::swap(cl[1], *k);
+                    watches[cl[1]].push_back(c);
+                    continue;
+                }
+
+                ws[j++] = c;
+                if(get_value(cl[0]) < 0) {
+                    for(++i; i != ws.size(); ++i)
+                        ws[j++] = ws[i];
+                    ws.resize(j);
+                    return c;
+                }
+
+                assign(cl[0], c);
+            }
+            ws.resize(j);
+        }
+
+        return no_clause;
+    }
+
+    void bump(unsigned var) {
+        activity[var] += activity_inc;
+        if(activity[var] > 1e100) {
+            for(double &a : activity)
+                a *= 1e-100;
+            activity_inc *= 1e-100;
+        }
+    }
+
+    // Derives the first-UIP clause; its asserting literal goes first
+    // and the literal with the highest backjump level goes second.
+    void analyze(unsigned conflict, std::vector<unsigned> &learnt) {
+        learnt.assign(1, 0);
+        unsigned counter = 0;
+        unsigned p = 0;
+        std::size_t index = trail.size();
+        unsigned c = conflict;
+        do {
+            for(unsigned *q = &lits[c] + (p ? 1 : 0); *q; ++q) {
+                unsigned var = get_var(*q);
+                if(seen[var] || levels[var] == 0)
+                    continue;
+                seen[var] = 1;
+                bump(var);
+                if(levels[var] == get_level())
+                    ++counter;
+                else
+                    learnt.push_back(*q);
+            }
+
+            while(!seen[get_var(trail[--index])]) {}
+            p = trail[index];
+            c = reasons[get_var(p)];
+            seen[get_var(p)] = 0;
+        } while(--counter > 0);
+
+        learnt[0] = p ^ 1;
+        for(std::size_t i = 1; i != learnt.size(); ++i) {
+            seen[get_var(learnt[i])] = 0;
+            if(levels[get_var(learnt[i])] > levels[get_var(learnt[1])])
+                std::swap(learnt[i], learnt[1]);
+        }
+
+        activity_inc *= 1 / 0.95;
+    }
+
+    void backtrack(unsigned level) {
+        std::size_t lim = trail_lims[level];
+        while(trail.size() != lim) {
+            unsigned lit = trail.back();
+            trail.pop_back();
+            values[lit] = values[lit ^ 1] = 0;
+        }
+        trail_lims.resize(level);
+        num_propagated = lim;
+    }
+
+    unsigned decide() const {
+        unsigned best = 0;
+        for(unsigned var = 1; var != activity.size(); ++var) {
+            if(values[var * 2] == 0 &&
+                    (!best || activity[var] > activity[best]))
+                best = var;
+        }
+        return best;
+    }
+
+public:
+    small_solver(const cnf &clauses) {
+        std::size_t num_vars = static_cast<std::size_t>(clauses.num_vars) + 1;
+        watches.resize(num_vars * 2);
+        values.resize(num_vars * 2);
+        levels.resize(num_vars);
+        reasons.resize(num_vars, no_clause);
+        activity.resize(num_vars);
+        seen.resize(num_vars);
+
+        std::vector<unsigned> clause;
+        auto i = clauses.lits.begin();
+        while(i != clauses.lits.end()) {
+            bool tautology = false;
+            clause.clear();
+            for(; *i; ++i) {
+                unsigned var = static_cast<unsigned>(std::abs(*i));
+                unsigned lit = var * 2 + (*i < 0);
+                if(contains(clause, lit ^ 1))
+                    tautology = true;
+                if(!contains(clause, lit))
+                    clause.push_back(lit);
+            }
+            ++i;
+
+            if(tautology)
+                continue;
+
+            if(clause.empty()) {
+                empty_clause = true;
+            } else if(clause.size() == 1) {
+                if(get_value(clause[0]) < 0)
+                    empty_clause = true;
+                else if(get_value(clause[0]) == 0)
+                    assign(clause[0], no_clause);
+            } else {
+                auto c = static_cast<unsigned>(lits.size());
+                lits.insert(lits.end(), clause.begin(), clause.end());
+                lits.push_back(0);
+                watch(c);
+            }
+        }
+    }
+
+    bool solve() {
+        if(empty_clause)
+            return false;
+
+        std::vector<unsigned> learnt;
+        for(;;) {
+            unsigned conflict = propagate();
+            if(conflict != no_clause) {
+                if(get_level() == 0)
+                    return false;
+
+                analyze(conflict, learnt);
+                if(learnt.size() == 1) {
+                    backtrack(0);
+                    assign(learnt[0], no_clause);
+                    continue;
+                }
+
+                backtrack(levels[get_var(learnt[1])]);
+                auto c = static_cast<unsigned>(lits.size());
+                lits.insert(lits.end(), learnt.begin(), learnt.end());
+                lits.push_back(0);
+                watch(c);
+                assign(learnt[0], c);
+                continue;
+            }
+
+            unsigned var = decide();
+            if(!var)
+                return true;
+
+            trail_lims.push_back(trail.size());
+            assign(var * 2 + 1, no_clause);
+        }
+    }
+};
+
+constexpr unsigned small_solver::no_clause;
+
+// The variables sum up to the parity modulo 2.
+struct xor_constraint {
+    std::vector<int> vars;
+    bool parity = false;
+};
+
+// Runs Gaussian elimination on the constraints. Returns false if they
+// are inconsistent. Otherwise, adds the units and equivalences they
+// imply.
+bool eliminate_xors(const std::vector<xor_constraint> &xors,
+                    cnf &clauses) {
+    std::unordered_map<int, std::size_t> columns;
+    std::vector<int> vars;
+    for(const xor_constraint &c : xors) {
+        for(int v : c.vars) {
+            if(columns.insert({v, vars.size()}).second)
+                vars.push_back(v);
+        }
+    }
+
+    using word = std::uint64_t;
+    constexpr std::size_t word_bits = 64;
+    std::size_t num_words = (vars.size() + word_bits - 1) / word_bits;
+    std::vector<std::vector<word>> rows;
+    std::vector<bool> parities;
+    for(const xor_constraint &c : xors) {
+        std::vector<word> row(num_words);
+        for(int v : c.vars) {
+            std::size_t col = columns[v];
+            row[col / word_bits] ^= word(1) << (col % word_bits);
+        }
+        rows.push_back(std::move(row));
+        parities.push_back(c.parity);
+    }
+
+    std::size_t rank = 0;
+    for(std::size_t col = 0; col != vars.size(); ++col) {
+        std::size_t w = col / word_bits;
+        word bit = word(1) << (col % word_bits);
+        std::size_t pivot = rank;
+        while(pivot != rows.size() && !(rows[pivot][w] & bit))
+            ++pivot;
+        if(pivot == rows.size())
+            continue;
+
+        std::swap(rows[pivot], rows[rank]);
+        bool p = parities[pivot];
+        parities[pivot] = parities[rank];
+        parities[rank] = p;
+
+        for(std::size_t r = 0; r != rows.size(); ++r) {
+            if(r == rank || !(rows[r][w] & bit))
+                continue;
+            for(std::size_t i = w; i != num_words; ++i)
+                rows[r][i] ^= rows[rank][i];
+            parities[r] = parities[r] != parities[rank];
+        }
+
+        ++rank;
+    }
+
+    for(std::size_t r = rank; r != rows.size(); ++r) {
+        if(parities[r])
+            return false;
+    }
+
+    // Every remaining row has its own pivot, so rows of one or two
+    // variables are never implied by the other rows.
+    for(std::size_t r = 0; r != rank; ++r) {
+        int row_vars[3];
+        unsigned n = 0;
+        for(std::size_t i = 0; i != num_words && n != 3; ++i) {
+            for(word bits = rows[r][i]; bits && n != 3; bits &= bits - 1) {
+                std::size_t col = i * word_bits;
+                for(word b = bits & ~(bits - 1); b != 1; b >>= 1)
+                    ++col;
+                row_vars[n++] = vars[col];
+            }
+        }
+
+        if(n == 1) {
+            clauses.add(parities[r] ? row_vars[0] : -row_vars[0]);
+            clauses.add(0);
+        } else if(n == 2) {
+            // A ^ B = 0  =>  (or ~A B) (or A ~B)
+            // A ^ B = 1  =>  (or A B) (or ~A ~B)
+            int a = row_vars[0];
+            int b = parities[r] ? -row_vars[1] : row_vars[1];
+            clauses.add(-a);
+            clauses.add(b);
+            clauses.add(0);
+            clauses.add(a);
+            clauses.add(-b);
+            clauses.add(0);
+        }
+    }
+
+    return true;
+}
+
 }
 
+struct detail::sat_job {
+    cnf clauses;
+    eqbool e;
+    bool miter = false;
+
+    // Refuted by the XOR reasoning.
+    bool refuted = false;
+
+    bool small = false;
+    bool has_profile = false;
+    std::size_t profile_index = 0;
+    sat_profile profile;
+
+    bool unsat = false;
+    double sat_time = 0;
+
+    // Nodes by variables, only collected for capturing queries.
+    std::vector<const node_def*> vars;
+
+    // Asynchronous equivalence checks only.
+    eqbool a, b;
+    std::unique_ptr<std::promise<bool>> promise;
+    std::function<void(bool)> callback;
+};
+
+struct detail::sat_pool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable pending_cv, done_cv;
+    std::deque<sat_job*> pending, done;
+
+    // Submitted, but not applied yet.
+    std::size_t num_in_flight = 0;
+
+    bool stopping = false;
+
+    explicit sat_pool(unsigned num_workers) {
+        for(unsigned i = 0; i != num_workers; ++i)
+            workers.emplace_back([this]() { run(); });
+    }
+
+    ~sat_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pending_cv.notify_all();
+        for(std::thread &w : workers)
+            w.join();
+        for(sat_job *job : done)
+            delete job;
+    }
+
+    void run() {
+        for(;;) {
+            sat_job *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                pending_cv.wait(lock, [this]() {
+                    return stopping || !pending.empty(); });
+                // Complete the submitted checks before stopping.
+                if(pending.empty())
+                    return;
+                job = pending.front();
+                pending.pop_front();
+            }
+
+            eqbool_context::run_sat_job(*job);
+
+            // Fulfil the promise under the lock, so that the job of a
+            // ready future is always found done.
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(job->promise)
+                    job->promise->set_value(job->unsat);
+                done.push_back(job);
+            }
+            done_cv.notify_all();
+        }
+    }
+};
+
 void detail::hasher::flatten_or_impl(std::vector<eqbool> &flattened,
                                      args_ref args) {
     for(eqbool a : args) {
@@ -107,7 +593,7 @@ std::size_t detail::hasher::operator () (const node_def &def) const {
 
 inline bool detail::matcher::operator () (const node_def &a,
                                           const node_def &b) const {
-    assert(&a.get_context() == &b.get_context());
+    assert(are_compatible(a.get_context(), b.get_context()));
     if(a.kind != b.kind)
         return false;
 
@@ -134,7 +620,129 @@ inline bool detail::matcher::operator () (const node_def &a,
 term_set_base::~term_set_base()
 {}
 
-void eqbool::propagate_impl() {
+std::size_t term_table::hash(const char *name, std::size_t len) {
+    // FNV-1a.
+    std::uint64_t h = 0xcbf29ce484222325;
+    for(std::size_t i = 0; i != len; ++i) {
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 0x100000001b3;
+    }
+    return static_cast<std::size_t>(h);
+}
+
+bool term_table::matches(uintptr_t t, const char *name,
+                         std::size_t len) const {
+    std::size_t begin = offsets[t];
+    return offsets[t + 1] - begin == len &&
+           names.compare(begin, len, name, len) == 0;
+}
+
+void term_table::grow() {
+    slots.assign(std::max<std::size_t>(slots.size() * 2, 64), 0);
+    std::size_t mask = slots.size() - 1;
+    for(uintptr_t t = 0; t != size(); ++t) {
+        std::size_t begin = offsets[t];
+        std::size_t i = hash(names.data() + begin,
+                             offsets[t + 1] - begin) & mask;
+        while(slots[i])
+            i = (i + 1) & mask;
+        slots[i] = t + 1;
+    }
+}
+
+uintptr_t term_table::add(const char *name, std::size_t len) {
+    // Keep at least half of the slots free.
+    if((size() + 1) * 2 > slots.size())
+        grow();
+
+    std::size_t mask = slots.size() - 1;
+    for(std::size_t i = hash(name, len) & mask;; i = (i + 1) & mask) {
+        uintptr_t slot = slots[i];
+        if(!slot) {
+            uintptr_t t = size();
+            names.append(name, len);
+            offsets.push_back(names.size());
+            slots[i] = t + 1;
+            return t;
+        }
+        if(matches(slot - 1, name, len))
+            return slot - 1;
+    }
+}
+
+term_memory_stats term_table::get_memory_stats() const {
+    term_memory_stats stats;
+    stats.num_terms = size();
+    stats.bytes = names.capacity() +
+                  offsets.capacity() * sizeof(offsets[0]) +
+                  slots.capacity() * sizeof(slots[0]);
+    return stats;
+}
+
+std::ostream &term_table::print(std::ostream &s, uintptr_t t) const {
+    return s.write(names.data() + offsets[t],
+                   static_cast<std::streamsize>(offsets[t + 1] - offsets[t]));
+}
+
+std::size_t latency_histogram::get_bucket(std::uint64_t ns) {
+    if(ns < num_sub_buckets)
+        return static_cast<std::size_t>(ns);
+
+    // The leading one and the next sub_bucket_bits bits.
+    unsigned shift = 0;
+    while((ns >> shift) >= num_sub_buckets * 2)
+        ++shift;
+    std::uint64_t sub_bucket = (ns >> shift) - num_sub_buckets;
+    return static_cast<std::size_t>((shift + 1) * num_sub_buckets +
+                                    sub_bucket);
+}
+
+std::uint64_t latency_histogram::get_bucket_limit(std::size_t bucket) {
+    if(bucket < num_sub_buckets)
+        return bucket;
+
+    unsigned shift = static_cast<unsigned>(bucket / num_sub_buckets - 1);
+    std::uint64_t sub_bucket = bucket % num_sub_buckets;
+    return ((num_sub_buckets + sub_bucket + 1) << shift) - 1;
+}
+
+void latency_histogram::add(std::uint64_t ns) {
+    std::size_t bucket = get_bucket(ns);
+    if(bucket >= counts.size())
+        counts.resize(bucket + 1);
+    ++counts[bucket];
+    ++count;
+    max = std::max(max, ns);
+}
+
+void latency_histogram::merge(const latency_histogram &other) {
+    if(other.counts.size() > counts.size())
+        counts.resize(other.counts.size());
+    for(std::size_t i = 0; i != other.counts.size(); ++i)
+        counts[i] += other.counts[i];
+    count += other.count;
+    max = std::max(max, other.max);
+}
+
+std::uint64_t latency_histogram::get_percentile(double p) const {
+    if(count == 0)
+        return 0;
+
+    // The rank of the sample, counting from one.
+    auto rank = static_cast<unsigned long>(
+        static_cast<double>(count) * p / 100 + 0.5);
+    rank = std::max(rank, 1ul);
+
+    unsigned long n = 0;
+    for(std::size_t i = 0; i != counts.size(); ++i) {
+        n += counts[i];
+        if(n >= rank)
+            return std::min(get_bucket_limit(i), max);
+    }
+    return max;
+}
+
+uintptr_t eqbool::follow(uintptr_t entry_code, unsigned long &num_steps) {
     uintptr_t inv = 0;
     uintptr_t code = entry_code;
     for(;;) {
@@ -145,34 +753,177 @@ void eqbool::propagate_impl() {
         if(s.entry_code == code)
             break;
         code = s.entry_code;
+        ++num_steps;
+    }
+    return code | (inv & detail::inversion_flag);
+}
+
+void eqbool::propagate_impl() {
+    unsigned long num_steps = 0;
+    entry_code = follow(entry_code, num_steps);
+
+    // Frozen contexts can be shared between threads.
+    if(detail::counters_enabled) {
+        eqbool_context &context = get_context();
+        if(!context.is_frozen()) {
+            ++context.stats.hot.num_propagations;
+            context.stats.hot.num_propagation_steps += num_steps;
+        }
     }
-    entry_code = code | (inv & detail::inversion_flag);
 }
 
 void eqbool::reduce() {
+    // Frozen nodes are never changed.
+    if(get_context().is_frozen())
+        return;
+
     entry_code |= detail::lock_flag;
     entry_code = get_context().reduce({}, *this).entry_code;
     entry_code &= ~detail::lock_flag;
 }
 
+eqbool_context::~eqbool_context() {
+    delete pool;
+    delete session;
+}
+
+eqbool_context::eqbool_context(const eqbool_context *base)
+        : base(base), terms(base->terms), dense_terms(base->dense_terms),
+          small_sat_threshold(base->small_sat_threshold),
+          sat_profiles(base->sat_profiles),
+          capture_dir(base->capture_dir),
+          capture_min_time(base->capture_min_time),
+          latency_recording(base->latency_recording),
+          max_implications(base->max_implications),
+          xor_reasoning(base->xor_reasoning), effort(base->effort),
+          sweep_position(base->defs.size()) {
+    assert(base->frozen && !base->base);
+    stats.sat_profiles.resize(sat_profiles.size());
+}
+
 eqbool eqbool_context::add_def(node_def def) {
-    def.id = defs.size();
+    assert(!frozen);
+
+    if(detail::counters_enabled) {
+        ++stats.hot.num_lookups;
+        if(defs.bucket_count() != 0)
+            stats.hot.num_lookup_probes += defs.bucket_size(defs.bucket(def));
+    }
+
+    // Nodes with arguments from the overlay cannot be in the base.
+    if(base) {
+        bool in_base = true;
+        for(eqbool a : def.args) {
+            if(&a.get_context() != base) {
+                in_base = false;
+                break;
+            }
+        }
+
+        if(in_base) {
+            auto i = base->defs.find(def);
+            if(i != base->defs.end()) {
+                count(stats.hot.num_base_lookup_hits);
+                eqbool value = i->second;
+                value.propagate();
+                return value;
+            }
+        }
+    }
+
+    def.id = get_first_id() + defs.size();
     auto r = defs.insert({def, eqbool()});
     auto &i = r.first;
     eqbool &value = i->second;
     bool inserted = r.second;
-    if(inserted)
+    if(inserted) {
+        count(stats.hot.num_inserts);
         value = eqbool(*i);
-    else
+        nodes.push_back(value);
+
+        const node_def &new_def = i->first;
+        ++num_nodes_by_kind[static_cast<int>(new_def.kind)];
+        num_args += new_def.args.size();
+        num_arg_slots += new_def.args.capacity();
+    } else {
+        count(stats.hot.num_lookup_hits);
         value.propagate();
+    }
     return value;
 }
 
+bool eqbool_context::start_recording() {
+    if(!recorder || recorder->busy)
+        return false;
+    recorder->busy = true;
+    return true;
+}
+
+bool eqbool_context::start_measuring() {
+    if(!latency_recording || measuring)
+        return false;
+    measuring = true;
+    return true;
+}
+
+void eqbool_context::finish_measuring(
+        latency_histogram &h,
+        std::chrono::time_point<std::chrono::steady_clock> start) {
+    std::chrono::nanoseconds ns = std::chrono::steady_clock::now() - start;
+    h.add(static_cast<std::uint64_t>(ns.count()));
+    measuring = false;
+}
+
 eqbool eqbool_context::get(uintptr_t term) {
-    return add_def(node_def(term, *this));
+    if(start_recording()) {
+        eqbool r = get(term);
+        recorder->busy = false;
+        recorder->record_term(term, r);
+        return r;
+    }
+
+    if(start_measuring()) {
+        auto start = std::chrono::steady_clock::now();
+        eqbool r = get(term);
+        finish_measuring(stats.latencies.get, start);
+        return r;
+    }
+
+    if(!dense_terms)
+        return add_def(node_def(term, *this));
+
+    if(term < term_nodes.size()) {
+        eqbool e = term_nodes[term];
+        if(e) {
+            e.propagate();
+            return e;
+        }
+    }
+
+    eqbool e = add_def(node_def(term, *this));
+    if(term >= term_nodes.size())
+        term_nodes.resize(term + 1);
+    term_nodes[term] = e;
+    return e;
 }
 
 eqbool eqbool_context::get_or(args_ref args, bool invert_args) {
+    if(start_recording()) {
+        eqbool r = get_or(args, invert_args);
+        recorder->busy = false;
+        recorder->record_or(args, invert_args, r);
+        return r;
+    }
+
+    if(start_measuring()) {
+        auto start = std::chrono::steady_clock::now();
+        eqbool r = get_or(args, invert_args);
+        finish_measuring(stats.latencies.get_or, start);
+        return r;
+    }
+
+    detail::scoped_timer build_timer(innermost_timer, stats.hot.build_time);
+
     // Order the arguments before simplifications so we never
     // depend on the order they are specified in.
     std::vector<eqbool> sorted_args(args.begin(), args.end());
@@ -182,7 +933,43 @@ eqbool eqbool_context::get_or(args_ref args, bool invert_args) {
     }
     std::sort(sorted_args.begin(), sorted_args.end());
 
+    if(effort == effort_level::fast) {
+        for(eqbool &a : sorted_args)
+            a.propagate();
+        std::sort(sorted_args.begin(), sorted_args.end());
+
+        // Inversions come immediately after their non-inverted
+        // versions, so repeated and complementary arguments are
+        // adjacent.
+        std::size_t num_args = 0;
+        for(eqbool a : sorted_args) {
+            if(a.is_true()) {
+                count(stats.hot.num_constant_folds);
+                return eqtrue;
+            }
+            if(a.is_false())
+                continue;
+            if(num_args != 0) {
+                eqbool prev = sorted_args[num_args - 1];
+                if(a == prev)
+                    continue;
+                if(a == ~prev)
+                    return eqtrue;
+            }
+            sorted_args[num_args++] = a;
+        }
+
+        sorted_args.resize(num_args);
+
+        if(num_args == 1)
+            return sorted_args[0];
+
+        node_def def(node_kind::or_node, sorted_args, *this);
+        return add_def(def);
+    }
+
     for(;;) {
+        count(stats.hot.num_reduction_rounds);
         bool repeat = false;
         for(eqbool &a : sorted_args) {
             eqbool s = reduce_impl(sorted_args, a);
@@ -199,8 +986,10 @@ eqbool eqbool_context::get_or(args_ref args, bool invert_args) {
 
     std::size_t num_args = 0;
     for(eqbool a : sorted_args) {
-        if(a.is_true())
+        if(a.is_true()) {
+            count(stats.hot.num_constant_folds);
             return eqtrue;
+        }
         if(!a.is_false())
             sorted_args[num_args++] = a;
     }
@@ -212,8 +1001,7 @@ eqbool eqbool_context::get_or(args_ref args, bool invert_args) {
 
     // (or (and A B) (and ~A C))  =>  (ifelse A B C)
     // (or ~(or ~A ~B) ~(or A ~C))  =>  (ifelse A B C)
-    if(num_args == 2 &&
-           sorted_args[0].is_inversion() &&
+    if(num_args == 2 && sorted_args[0].is_inversion() &&
            sorted_args[1].is_inversion()) {
         const node_def &def0 = (~sorted_args[0]).get_def();
         const node_def &def1 = (~sorted_args[1]).get_def();
@@ -225,6 +1013,7 @@ eqbool eqbool_context::get_or(args_ref args, bool invert_args) {
                         eqbool i = ~def0.args[p];
                         eqbool t = ~def0.args[p ^ 1];
                         eqbool e = ~def1.args[q ^ 1];
+                        count(stats.hot.num_ifelse_recognitions);
                         return ifelse(i, t, e);
                     }
                 }
@@ -250,9 +1039,25 @@ void eqbool_context::add_eq(std::vector<eqbool> &eqs, eqbool e) {
         eqs.push_back(e);
 }
 
+eqbool eqbool_context::get_implied_value(const std::vector<eqbool> &eqs,
+                                         eqbool premise) {
+    auto i = implications.find(premise.entry_code);
+    if(i == implications.end())
+        return {};
+
+    for(eqbool c : i->second) {
+        if(contains(eqs, c) || contains(eqs, ~c)) {
+            ++stats.num_implication_hits;
+            return get(contains(eqs, c));
+        }
+    }
+
+    return {};
+}
+
 eqbool eqbool_context::evaluate(args_ref assumed_falses,
                                 const eqbool &excluded,
-                                std::vector<eqbool> &eqs) const {
+                                std::vector<eqbool> &eqs) {
    for(const eqbool &a : assumed_falses) {
         if(&a == &excluded)
             continue;
@@ -260,6 +1065,11 @@ eqbool eqbool_context::evaluate(args_ref assumed_falses,
         if(eqbool v = get_value(eqs, a))
             return v;
 
+        if(!implications.empty()) {
+            if(eqbool v = get_implied_value(eqs, ~a))
+                return v;
+        }
+
         bool inv = a.is_inversion();
         const node_def &def = (a ^ inv).get_def();
         if(def.kind == node_kind::eq) {
@@ -278,11 +1088,16 @@ eqbool eqbool_context::evaluate(args_ref assumed_falses,
 
 eqbool eqbool_context::evaluate(args_ref assumed_falses,
                                 const eqbool &excluded,
-                                eqbool e, std::vector<eqbool> &eqs) const {
+                                eqbool e, std::vector<eqbool> &eqs) {
+    detail::scoped_timer evaluate_timer(innermost_timer,
+                                        stats.hot.evaluate_time);
+    count(stats.hot.num_evaluations);
+
     e.propagate();
 
     eqs = {e};
     for(;;) {
+        count(stats.hot.num_evaluation_rounds);
         std::size_t num_eqs = eqs.size();
         if(eqbool r = evaluate(assumed_falses, excluded, eqs))
             return r;
@@ -300,7 +1115,7 @@ eqbool eqbool_context::evaluate(args_ref assumed_falses,
 }
 
 eqbool eqbool_context::evaluate(args_ref assumed_falses,
-                                const eqbool &excluded, eqbool e) const {
+                                const eqbool &excluded, eqbool e) {
     std::vector<eqbool> eqs;
     return evaluate(assumed_falses, excluded, e, eqs);
 }
@@ -323,6 +1138,10 @@ bool eqbool_context::contains_all(args_ref p, args_ref q) {
 }
 
 eqbool eqbool_context::reduce_impl(args_ref assumed_falses, eqbool &e) {
+    detail::scoped_timer reduce_timer(innermost_timer,
+                                      stats.hot.reduce_time);
+    count(stats.hot.num_reductions);
+
     e.propagate();
 
     if(e.is_const())
@@ -377,6 +1196,8 @@ eqbool eqbool_context::reduce_impl(args_ref assumed_falses, eqbool &e) {
         if(s)
             return s ^ inv;
         // (or (and A...) (and A... B...) C...) => (or (and A...) C...)
+        if(effort == effort_level::fast)
+            return e;
         for(const eqbool &a : assumed_falses) {
             if(&a == &excluded)
                 continue;
@@ -385,8 +1206,10 @@ eqbool eqbool_context::reduce_impl(args_ref assumed_falses, eqbool &e) {
             const node_def &a_def = (~a).get_def();
             if(a_def.kind != node_kind::or_node)
                 continue;
-            if(contains_all(def.args, a_def.args))
+            if(contains_all(def.args, a_def.args)) {
+                count(stats.hot.num_subsumptions);
                 return get(!inv);
+            }
         }
         return e;
     }
@@ -395,6 +1218,7 @@ eqbool eqbool_context::reduce_impl(args_ref assumed_falses, eqbool &e) {
 
 eqbool eqbool_context::reduce(args_ref assumed_falses, eqbool e) {
     for(;;) {
+        count(stats.hot.num_reduction_rounds);
         eqbool r = reduce_impl(assumed_falses, e);
         if(r == e)
             break;
@@ -403,29 +1227,97 @@ eqbool eqbool_context::reduce(args_ref assumed_falses, eqbool e) {
     return e;
 }
 
+eqbool eqbool_context::fold(eqbool assumed_false, eqbool e) const {
+    e.propagate();
+    if(e == assumed_false)
+        return eqfalse;
+    if(e == ~assumed_false)
+        return eqtrue;
+    return e;
+}
+
+static void collect_eq_leaves(eqbool e, std::vector<eqbool> &leaves,
+                              bool &inv) {
+    e.propagate();
+    inv ^= e.is_inversion();
+    e = e ^ e.is_inversion();
+    if(e.get_kind() != node_kind::eq) {
+        leaves.push_back(e);
+        return;
+    }
+
+    // (eq A B) = ~(xor A B)
+    inv ^= true;
+    for(eqbool a : e.get_args())
+        collect_eq_leaves(a, leaves, inv);
+}
+
+eqbool eqbool_context::cancel_eq_leaves(eqbool a, eqbool b) {
+    std::vector<eqbool> leaves;
+    bool inv = true;
+    collect_eq_leaves(a, leaves, inv);
+    collect_eq_leaves(b, leaves, inv);
+    std::sort(leaves.begin(), leaves.end());
+
+    std::size_t num_leaves = 0;
+    for(eqbool l : leaves) {
+        if(num_leaves != 0 && leaves[num_leaves - 1] == l)
+            --num_leaves;
+        else
+            leaves[num_leaves++] = l;
+    }
+
+    if(num_leaves == leaves.size())
+        return {};
+
+    // The leaves are XORed.
+    eqbool r = get(inv);
+    for(std::size_t n = 0; n != num_leaves; ++n)
+        r = ~get_eq(r, leaves[n]);
+    return r;
+}
+
 eqbool eqbool_context::ifelse_impl(eqbool i, eqbool t, eqbool e) {
     check(i);
     check(t);
     check(e);
 
-    i = reduce({}, i);
-    t = reduce({~i}, t);
-    e = reduce({i}, e);
+    if(effort == effort_level::fast) {
+        i.propagate();
+        t = fold(~i, t);
+        e = fold(i, e);
 
-    if(t == ~e) {
-        std::tie(i, t, e) = std::make_tuple(t, i, ~i);
+        if(t == ~e) {
+            std::tie(i, t, e) = std::make_tuple(t, i, ~i);
+            t = fold(~i, t);
+            e = fold(i, e);
+        }
+    } else {
+        i = reduce({}, i);
         t = reduce({~i}, t);
         e = reduce({i}, e);
+
+        if(t == ~e) {
+            std::tie(i, t, e) = std::make_tuple(t, i, ~i);
+            t = reduce({~i}, t);
+            e = reduce({i}, e);
+        }
     }
 
-    if(i.is_const())
+    if(i.is_const()) {
+        count(stats.hot.num_constant_folds);
         return i.is_true() ? t : e;
+    }
 
-    if(t.is_const())
-        return t.is_false() ? (~i & e) : (i | e);
+    if(t.is_const()) {
+        count(stats.hot.num_constant_folds);
+        return t.is_false() ? get_and(~i, e) : get_or(i, e);
+    }
 
-    if(e.is_const())
-        return e.is_false() ? (i & t) : (~i | t);
+    if(e.is_const()) {
+        count(stats.hot.num_constant_folds);
+        return e.is_false() ? get_and(i, t) : get_or(~i, t);
+    }
 
     if(t == e)
         return t;
@@ -438,6 +1330,13 @@ eqbool eqbool_context::ifelse_impl(eqbool i, eqbool t, eqbool e) {
 
     if(t == ~e) {
         assert(!i.is_inversion());
+        if(effort == effort_level::strong) {
+            if(eqbool r = cancel_eq_leaves(i, t)) {
+                count(stats.hot.num_eq_cancellations);
+                return r;
+            }
+        }
+
         bool inv = t.is_inversion();
         node_def def(node_kind::eq, {i, t ^ inv}, *this);
         return add_def(def) ^ inv;
@@ -449,6 +1348,22 @@ eqbool eqbool_context::ifelse_impl(eqbool i, eqbool t, eqbool e) {
 }
 
 eqbool eqbool_context::ifelse(eqbool i, eqbool t, eqbool e) {
+    if(start_recording()) {
+        eqbool r = ifelse(i, t, e);
+        recorder->busy = false;
+        recorder->record_ifelse(i, t, e, r);
+        return r;
+    }
+
+    if(start_measuring()) {
+        auto start = std::chrono::steady_clock::now();
+        eqbool r = ifelse(i, t, e);
+        finish_measuring(stats.latencies.ifelse, start);
+        return r;
+    }
+
+    detail::scoped_timer build_timer(innermost_timer, stats.hot.build_time);
+
     eqbool r = ifelse_impl(i, t, e);
 
     if(r.is_const() && t == ~e)
@@ -477,22 +1392,51 @@ int eqbool_context::skip_not(eqbool &e,
     return get_literal(&e.get_def(), literals);
 }
 
-bool eqbool_context::is_unsat(eqbool e) {
-    if(e.is_const())
-        return e.is_false();
+std::vector<sat_profile> eqbool_context::get_default_sat_profiles() {
+    std::vector<sat_profile> profiles(3);
 
-    auto *solver = new CaDiCaL::Solver;
+    // Inprocessing and preprocessing do not pay off on small queries.
+    profiles[0].name = "plain";
+    profiles[0].config = "plain";
+    profiles[0].max_clauses = 2000;
 
-    {
-    timer t(stats.clauses_time);
+    // Equivalence miters mostly come out unsatisfiable.
+    profiles[1].name = "unsat";
+    profiles[1].config = "unsat";
+    profiles[1].min_unsat_ratio = 0.5;
 
-    std::unordered_map<const node_def*, int> literals;
-    solver->add(skip_not(e, literals));
-    solver->add(0);
-    ++stats.num_clauses;
+    profiles[2].name = "default";
+    return profiles;
+}
+
+void eqbool_context::set_sat_profiles(std::vector<sat_profile> profiles) {
+    sat_profiles = std::move(profiles);
+    stats.sat_profiles.assign(sat_profiles.size(), sat_profile_stats());
+}
+
+std::size_t eqbool_context::select_sat_profile(
+        unsigned long num_clauses, const sat_history &history) const {
+    // Profiles that need a minimum ratio of unsatisfiable queries
+    // do not match until there is some history.
+    double unsat_ratio = static_cast<double>(history.num_unsat + 1) /
+                         static_cast<double>(history.num_queries + 2);
+    std::size_t i = 0;
+    for(; i != sat_profiles.size(); ++i) {
+        const sat_profile &p = sat_profiles[i];
+        if(p.min_unsat_ratio > 0 && history.num_queries == 0)
+            continue;
+        if(num_clauses <= p.max_clauses && unsat_ratio >= p.min_unsat_ratio)
+            break;
+    }
+    return i;
+}
+
+int eqbool_context::encode(cnf &clauses, eqbool e,
+        std::unordered_map<const node_def*, int> &literals,
+        std::unordered_set<const node_def*> &visited) {
+    int e_lit = skip_not(e, literals);
 
     std::vector<eqbool> worklist({e});
-    std::unordered_set<const node_def*> visited;
     while(!worklist.empty()) {
         eqbool n = worklist.back();
         worklist.pop_back();
@@ -512,20 +1456,18 @@ bool eqbool_context::is_unsat(eqbool e) {
             std::vector<int> arg_lits;
             for(eqbool a : def.args) {
                 int a_lit = skip_not(a, literals);
-                solver->add(-a_lit);
-                solver->add(r_lit);
-                solver->add(0);
-                ++stats.num_clauses;
+                clauses.add(-a_lit);
+                clauses.add(r_lit);
+                clauses.add(0);
 
                 arg_lits.push_back(a_lit);
                 worklist.push_back(a);
             }
 
             for(int a_lit : arg_lits)
-                solver->add(a_lit);
-            solver->add(-r_lit);
-            solver->add(0);
-            ++stats.num_clauses;
+                clauses.add(a_lit);
+            clauses.add(-r_lit);
+            clauses.add(0);
             continue; }
         case node_kind::ifelse:
         case node_kind::eq: {
@@ -536,29 +1478,25 @@ bool eqbool_context::is_unsat(eqbool e) {
             int t_lit = skip_not(t_arg, literals);
             int e_lit = skip_not(e_arg, literals);
 
-            solver->add(-i_lit);
-            solver->add(t_lit);
-            solver->add(-r_lit);
-            solver->add(0);
-            ++stats.num_clauses;
-
-            solver->add(-i_lit);
-            solver->add(-t_lit);
-            solver->add(r_lit);
-            solver->add(0);
-            ++stats.num_clauses;
-
-            solver->add(i_lit);
-            solver->add(e_lit);
-            solver->add(-r_lit);
-            solver->add(0);
-            ++stats.num_clauses;
-
-            solver->add(i_lit);
-            solver->add(-e_lit);
-            solver->add(r_lit);
-            solver->add(0);
-            ++stats.num_clauses;
+            clauses.add(-i_lit);
+            clauses.add(t_lit);
+            clauses.add(-r_lit);
+            clauses.add(0);
+
+            clauses.add(-i_lit);
+            clauses.add(-t_lit);
+            clauses.add(r_lit);
+            clauses.add(0);
+
+            clauses.add(i_lit);
+            clauses.add(e_lit);
+            clauses.add(-r_lit);
+            clauses.add(0);
+
+            clauses.add(i_lit);
+            clauses.add(-e_lit);
+            clauses.add(r_lit);
+            clauses.add(0);
 
             worklist.push_back(i_arg);
             worklist.push_back(t_arg);
@@ -567,21 +1505,700 @@ bool eqbool_context::is_unsat(eqbool e) {
         }
         unreachable("unknown node kind");
     }
+
+    return e_lit;
+}
+
+bool eqbool_context::add_xor_clauses(cnf &clauses, int root_lit,
+        std::unordered_map<const node_def*, int> &literals,
+        const std::unordered_set<const node_def*> &visited) {
+    std::vector<const node_def*> eqs;
+    for(const node_def *def : visited) {
+        if(def->kind == node_kind::eq)
+            eqs.push_back(def);
+    }
+
+    // A single XOR gives nothing the solver would not see right
+    // away. Too many make the elimination too expensive.
+    constexpr std::size_t max_xors = 1024;
+    if(eqs.size() < 2 || eqs.size() >= max_xors)
+        return true;
+
+    // Keep the derived clauses independent of the hashing.
+    std::sort(eqs.begin(), eqs.end(),
+              [](const node_def *a, const node_def *b) {
+                  return a->id < b->id; });
+
+    // (eq X Y) is R  =>  R ^ X ^ Y = 1
+    std::vector<xor_constraint> xors;
+    for(const node_def *def : eqs) {
+        eqbool x = def->args[0];
+        eqbool y = def->args[1];
+        int r_lit = literals[def];
+        int x_lit = skip_not(x, literals);
+        int y_lit = skip_not(y, literals);
+        xor_constraint c;
+        c.vars = {r_lit, std::abs(x_lit), std::abs(y_lit)};
+        c.parity = !((x_lit < 0) ^ (y_lit < 0));
+        xors.push_back(c);
     }
 
-    bool unsat;
+    xor_constraint root;
+    root.vars = {std::abs(root_lit)};
+    root.parity = root_lit > 0;
+    xors.push_back(root);
+
+    unsigned long num_clauses = clauses.num_clauses;
+    bool consistent = eliminate_xors(xors, clauses);
+    stats.num_xor_clauses += clauses.num_clauses - num_clauses;
+    return consistent;
+}
+
+bool eqbool_context::prepare_sat_job(sat_job &job, eqbool e, bool miter) {
+    job.e = e;
+    job.miter = miter;
+
     {
-        timer t(stats.sat_time);
-        unsat = solver->solve() == 20;
+        timer t(stats.clauses_time);
+        std::unordered_map<const node_def*, int> literals;
+        std::unordered_set<const node_def*> visited;
+        int e_lit = encode(job.clauses, e, literals, visited);
+        job.clauses.add(e_lit);
+        job.clauses.add(0);
+
+        if(!capture_dir.empty()) {
+            job.vars.resize(static_cast<std::size_t>(job.clauses.num_vars));
+            for(const auto &l : literals)
+                job.vars[static_cast<std::size_t>(l.second - 1)] = l.first;
+        }
+
+        if(xor_reasoning) {
+            timer xt(stats.xor_time);
+            job.refuted = !add_xor_clauses(job.clauses, e_lit, literals,
+                                           visited);
+        }
     }
 
-    ++stats.num_sat_solutions;
+    stats.num_clauses += job.clauses.num_clauses;
+
+    if(job.refuted) {
+        job.unsat = true;
+        return false;
+    }
+
+    job.small = job.clauses.num_clauses <= small_sat_threshold;
+    if(!job.small) {
+        const sat_history &history = miter ? miter_history : other_history;
+        job.profile_index = select_sat_profile(job.clauses.num_clauses,
+                                               history);
+        job.has_profile = job.profile_index != sat_profiles.size();
+        if(job.has_profile)
+            job.profile = sat_profiles[job.profile_index];
+    }
+
+    return true;
+}
+
+static bool configure(CaDiCaL::Solver &solver, const sat_profile &profile) {
+    if(!solver.configure(profile.config.c_str()))
+        return false;
+    for(const auto &option : profile.options) {
+        if(!solver.set(option.first.c_str(), option.second))
+            return false;
+    }
+    return true;
+}
+
+bool eqbool_context::is_valid_sat_profile(const sat_profile &profile) {
+    CaDiCaL::Solver solver;
+    return configure(solver, profile);
+}
+
+void eqbool_context::run_sat_job(sat_job &job) {
+    timer t(job.sat_time);
+    if(job.small) {
+        job.unsat = !small_solver(job.clauses).solve();
+        return;
+    }
+
+    auto *solver = new CaDiCaL::Solver;
+    if(job.has_profile) {
+        bool valid = configure(*solver, job.profile);
+        assert(valid);
+        static_cast<void>(valid);
+    }
+
+    for(int lit : job.clauses.lits)
+        solver->add(lit);
+
+    job.unsat = solver->solve() == 20;
 
     delete solver;
+}
+
+bool eqbool_context::finish_sat_job(sat_job &job) {
+    bool unsat = job.unsat;
+    if(job.refuted) {
+        ++stats.num_xor_refutations;
+    } else {
+        stats.sat_time += job.sat_time;
+        if(job.small) {
+            ++stats.num_small_sat_solutions;
+        } else {
+            // The profiles may have been replaced in the meantime.
+            if(job.has_profile &&
+                   job.profile_index < stats.sat_profiles.size()) {
+                sat_profile_stats &ps = stats.sat_profiles[job.profile_index];
+                ps.sat_time += job.sat_time;
+                ++ps.num_sat_solutions;
+                if(unsat)
+                    ++ps.num_unsat;
+            }
+
+            sat_history &history = job.miter ? miter_history : other_history;
+            ++history.num_queries;
+            if(unsat)
+                ++history.num_unsat;
+        }
+
+        ++stats.num_sat_solutions;
+    }
+
+    if(!job.refuted && !capture_dir.empty() &&
+           job.sat_time >= capture_min_time)
+        capture_query(job);
+
+    // (and A B) is unsatisfiable  =>  A -> ~B
+    eqbool e = job.e;
+    if(unsat && e.is_inversion()) {
+        const node_def &def = (~e).get_def();
+        if(def.kind == node_kind::or_node && def.args.size() == 2)
+            learn_implication(~def.args[0], def.args[1]);
+    }
 
     return unsat;
 }
 
+void eqbool_context::capture_query(const sat_job &job) {
+    static std::atomic<unsigned long> num_queries{0};
+    std::ofstream f(get_capture_path(capture_dir, num_queries++));
+
+    f << "c eqbool query\n"
+         "c kind: " << (job.miter ? "equivalence" : "satisfiability") << "\n"
+         "c solver: " << (job.small ? "small" :
+                          job.has_profile ? job.profile.name :
+                          "cadical") << "\n"
+         "c result: " << (job.unsat ? "unsat" : "sat") << "\n"
+         "c time: " << job.sat_time << "\n"
+         "c expr: ";
+    print(f, job.e) << "\n";
+    for(std::size_t i = 0; i != job.vars.size(); ++i) {
+        const node_def *def = job.vars[i];
+        if(!def)
+            continue;
+        f << "c var " << i + 1 << ": node " << def->id;
+        if(def->kind == node_kind::term) {
+            f << " term ";
+            terms.print(f, def->term);
+        }
+        f << "\n";
+    }
+    job.clauses.write_dimacs(f);
+
+    if(f.flush())
+        ++stats.num_captured_queries;
+}
+
+bool eqbool_context::is_unsat(const cnf &clauses,
+                              const sat_profile &profile) {
+    sat_job job;
+    job.clauses = clauses;
+    job.has_profile = true;
+    job.profile = profile;
+    run_sat_job(job);
+    return job.unsat;
+}
+
+bool eqbool_context::is_unsat(eqbool e, bool miter) {
+    if(e.is_const())
+        return e.is_false();
+
+    sat_job job;
+    if(prepare_sat_job(job, e, miter))
+        run_sat_job(job);
+    return finish_sat_job(job);
+}
+
+bool eqbool_context::solve_under(eqbool e, args_ref assumptions) {
+    check(e);
+    for(eqbool a : assumptions)
+        check(a);
+
+    // Start over once the accumulated clauses outweigh the savings
+    // on reencoding.
+    constexpr unsigned long max_session_clauses = 1000000;
+    if(session && session->num_clauses > max_session_clauses) {
+        delete session;
+        session = nullptr;
+    }
+
+    if(!session)
+        session = new detail::sat_session;
+
+    cnf clauses;
+    std::vector<int> assumed_lits;
+    {
+        timer t(stats.clauses_time);
+        assumed_lits.push_back(encode(clauses, e, session->literals,
+                                      session->visited));
+        for(eqbool a : assumptions)
+            assumed_lits.push_back(encode(clauses, a, session->literals,
+                                          session->visited));
+    }
+
+    stats.num_clauses += clauses.num_clauses;
+    session->num_clauses += clauses.num_clauses;
+
+    bool sat;
+    {
+        timer t(stats.sat_time);
+        for(int lit : clauses.lits)
+            session->solver.add(lit);
+        for(int lit : assumed_lits)
+            session->solver.assume(lit);
+        sat = session->solver.solve() == 10;
+    }
+
+    ++stats.num_sat_solutions;
+    ++stats.num_assumption_sat_solutions;
+    return sat;
+}
+
+bool eqbool_context::is_sat_under(eqbool e, args_ref assumptions) {
+    bool sat = solve_under(e, assumptions);
+    if(!sat && assumptions.size() == 1)
+        learn_implication(assumptions[0], ~e);
+    return sat;
+}
+
+void eqbool_context::set_max_learned_implications(std::size_t n) {
+    max_implications = n;
+    while(implication_order.size() > max_implications)
+        forget_implication();
+}
+
+void eqbool_context::forget_implication() {
+    std::pair<eqbool, eqbool> oldest = implication_order.front();
+    implication_order.pop_front();
+
+    std::vector<eqbool> &conclusions = implications[oldest.first.entry_code];
+    conclusions.erase(std::find(conclusions.begin(), conclusions.end(),
+                                oldest.second));
+    if(conclusions.empty())
+        implications.erase(oldest.first.entry_code);
+}
+
+// Records a -> b and its contrapositive.
+void eqbool_context::learn_implication(eqbool a, eqbool b) {
+    a.propagate();
+    b.propagate();
+    if(a.is_const() || b.is_const() || a == b || max_implications == 0)
+        return;
+
+    for(const std::pair<eqbool, eqbool> &i :
+            {std::make_pair(a, b), std::make_pair(~b, ~a)}) {
+        std::vector<eqbool> &conclusions = implications[i.first.entry_code];
+        if(contains(conclusions, i.second))
+            continue;
+
+        if(implication_order.size() == max_implications)
+            forget_implication();
+
+        // The eviction may have released the vector we hold.
+        implications[i.first.entry_code].push_back(i.second);
+        implication_order.push_back(i);
+        ++stats.num_learned_implications;
+    }
+}
+
+sweep_result eqbool_context::sweep(unsigned long max_sat_calls) {
+    sweep_result r;
+    timer t(r.time);
+
+    // Nodes of the base context only represent other nodes.
+    std::size_t first_id = get_first_id();
+    std::size_t num_nodes = first_id + nodes.size();
+    auto get_node = [&](std::size_t id) {
+        return id < first_id ? base->nodes[id] : nodes[id - first_id];
+    };
+
+    // Simulate all nodes on the same random patterns.
+    constexpr std::size_t num_words = 4;
+    using signature = std::array<std::uint64_t, num_words>;
+    std::vector<signature> sigs(num_nodes);
+    std::uint64_t seed = 0;
+    for(std::size_t id = 0; id != num_nodes; ++id) {
+        const node_def &def = get_node(id).get_def();
+        signature &sig = sigs[id];
+        switch(def.kind) {
+        case node_kind::term:
+            for(std::uint64_t &w : sig) {
+                // splitmix64
+                std::uint64_t z = (seed += 0x9e3779b97f4a7c15);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                w = z ^ (z >> 31);
+            }
+            continue;
+        case node_kind::or_node:
+        case node_kind::ifelse:
+        case node_kind::eq: {
+            signature args[3];
+            for(std::size_t i = 0; i != num_words; ++i)
+                sig[i] = 0;
+            for(std::size_t a = 0; a != def.args.size(); ++a) {
+                eqbool arg = def.args[a];
+                bool inv = arg.is_inversion();
+                const signature &arg_sig = sigs[arg.get_id() / 2];
+                for(std::size_t i = 0; i != num_words; ++i) {
+                    std::uint64_t w = inv ? ~arg_sig[i] : arg_sig[i];
+                    if(def.kind == node_kind::or_node)
+                        sig[i] |= w;
+                    else
+                        args[a][i] = w;
+                }
+            }
+            for(std::size_t i = 0; i != num_words; ++i) {
+                if(def.kind == node_kind::ifelse)
+                    sig[i] = (args[0][i] & args[1][i]) |
+                             (~args[0][i] & args[2][i]);
+                else if(def.kind == node_kind::eq)
+                    sig[i] = ~(args[0][i] ^ args[1][i]);
+            }
+            continue; }
+        }
+        unreachable("unknown node kind");
+    }
+
+    // Classes of nodes that are equivalent or inverse of each other
+    // on the patterns, keyed by signatures normalised to have the
+    // first bit cleared.
+    struct signature_hasher {
+        std::size_t operator () (const signature &sig) const {
+            std::size_t h = 0;
+            for(std::uint64_t w : sig)
+                detail::hasher::hash(h, w);
+            return h;
+        }
+    };
+    std::unordered_map<signature, std::vector<eqbool>, signature_hasher>
+        classes;
+
+    // Set when the budget runs out before all nodes are looked at.
+    bool stopped = false;
+    auto take_sat_call = [&]() {
+        if(r.num_sat_calls >= max_sat_calls) {
+            stopped = true;
+            return false;
+        }
+        ++r.num_sat_calls;
+        return true;
+    };
+
+    for(std::size_t id = 0; id != num_nodes; ++id) {
+        eqbool n = get_node(id);
+        if(n.get_entry().second != n)
+            continue;  // Already merged.
+
+        bool inv = sigs[id][0] & 1;
+        signature key = sigs[id];
+        if(inv) {
+            for(std::uint64_t &w : key)
+                w = ~w;
+        }
+        std::vector<eqbool> &reps = classes[key];
+
+        // Terms can only represent other nodes.
+        if(id < sweep_position || n.get_kind() == node_kind::term) {
+            reps.push_back(n ^ inv);
+            continue;
+        }
+
+        bool merged = false;
+        eqbool m = n ^ inv;
+        for(eqbool rep : reps) {
+            // Both n & ~rep and ~n & rep have to be unsatisfiable.
+            // The merge makes the implications redundant, so they are
+            // not learned.
+            if(!take_sat_call())
+                break;
+            if(solve_under(m, {~rep}))
+                continue;
+            if(!take_sat_call())
+                break;
+            if(solve_under(~m, {rep}))
+                continue;
+
+            store_equiv(m, rep);
+            ++r.num_merged;
+            merged = true;
+            break;
+        }
+
+        // Look at the node again next time.
+        if(stopped) {
+            sweep_position = id;
+            break;
+        }
+
+        sweep_position = id + 1;
+
+        if(!merged)
+            reps.push_back(m);
+    }
+
+    r.complete = !stopped;
+    if(r.complete)
+        sweep_position = num_nodes;
+
+    t.update();
+    stats.sweep_time += r.time;
+    stats.num_swept_merges += r.num_merged;
+    return r;
+}
+
+eqbool eqbool_context::rebuild(node_kind kind, args_ref args) {
+    switch(kind) {
+    case node_kind::term:
+        break;
+    case node_kind::or_node:
+        return get_or(args);
+    case node_kind::ifelse:
+        return ifelse(args[0], args[1], args[2]);
+    case node_kind::eq:
+        return get_eq(args[0], args[1]);
+    }
+    unreachable("unexpected node kind");
+}
+
+eqbool eqbool_context::substitute_impl(eqbool e, substitution &subst) {
+    e.propagate();
+    bool inv = e.is_inversion();
+    e = e ^ inv;
+
+    // Rebuild the nodes in topological order.
+    std::vector<eqbool> worklist({e});
+    std::vector<eqbool> args;
+    while(!worklist.empty()) {
+        eqbool n = worklist.back();
+        if(subst.rebuilt.find(n.entry_code) != subst.rebuilt.end()) {
+            worklist.pop_back();
+            continue;
+        }
+
+        const node_def &def = n.get_def();
+        args.clear();
+        bool ready = true;
+        for(eqbool a : def.args) {
+            a.propagate();
+            bool a_inv = a.is_inversion();
+            auto i = subst.rebuilt.find((a ^ a_inv).entry_code);
+            if(i == subst.rebuilt.end()) {
+                worklist.push_back(a ^ a_inv);
+                ready = false;
+                continue;
+            }
+            args.push_back(i->second ^ a_inv);
+        }
+
+        if(!ready)
+            continue;
+
+        worklist.pop_back();
+
+        eqbool r;
+        if(def.kind == node_kind::term) {
+            auto v = subst.values.find(def.term);
+            r = v != subst.values.end() ? v->second : n;
+            check(r);
+        } else {
+            r = rebuild(def.kind, args);
+        }
+
+        subst.rebuilt[n.entry_code] = r;
+    }
+
+    return subst.rebuilt[e.entry_code] ^ inv;
+}
+
+eqbool eqbool_context::substitute(eqbool e, substitution &subst) {
+    check(e);
+    e = substitute_impl(e, subst);
+    e.propagate();
+    return e;
+}
+
+void eqbool_context::substitute(std::vector<eqbool> &roots,
+                                substitution &subst) {
+    for(eqbool &e : roots)
+        e = substitute(e, subst);
+}
+
+eqbool eqbool_context::import_impl(eqbool e, import_map &map) {
+    // Source nodes are only resolved, never reduced, so the source
+    // context stays unchanged.
+    e = e.resolve();
+    bool inv = e.is_inversion();
+    e = e ^ inv;
+
+    // Translate the nodes in topological order.
+    std::vector<eqbool> worklist({e});
+    std::vector<eqbool> args;
+    while(!worklist.empty()) {
+        eqbool n = worklist.back();
+        if(map.nodes.find(n.entry_code) != map.nodes.end()) {
+            worklist.pop_back();
+            continue;
+        }
+
+        const node_def &def = n.get_def();
+        args.clear();
+        bool ready = true;
+        for(eqbool a : def.args) {
+            a = a.resolve();
+            bool a_inv = a.is_inversion();
+            auto i = map.nodes.find((a ^ a_inv).entry_code);
+            if(i == map.nodes.end()) {
+                worklist.push_back(a ^ a_inv);
+                ready = false;
+                continue;
+            }
+            args.push_back(i->second ^ a_inv);
+        }
+
+        if(!ready)
+            continue;
+
+        worklist.pop_back();
+
+        eqbool r;
+        if(def.kind == node_kind::term) {
+            auto t = map.terms.find(def.term);
+            r = get(t != map.terms.end() ? t->second : def.term);
+        } else {
+            r = rebuild(def.kind, args);
+        }
+
+        map.nodes[n.entry_code] = r;
+    }
+
+    return map.nodes[e.entry_code] ^ inv;
+}
+
+eqbool eqbool_context::import(const eqbool_context &src, eqbool e,
+                              import_map &map) {
+    assert(&e.get_context() == &src);
+    assert(!map.src || map.src == &src);
+    map.src = &src;
+
+    e = import_impl(e, map);
+    e.propagate();
+    return e;
+}
+
+void eqbool_context::import(const eqbool_context &src,
+                            std::vector<eqbool> &roots, import_map &map) {
+    for(eqbool &e : roots)
+        e = import(src, e, map);
+}
+
+void eqbool_context::compact(std::vector<eqbool> &handles) {
+    assert(!frozen && !recorder);
+    sync();
+
+    std::size_t first_id = get_first_id();
+
+    // Mark the nodes to keep.
+    std::vector<bool> live(nodes.size());
+    std::vector<eqbool> worklist;
+    for(eqbool h : handles) {
+        if(h)
+            worklist.push_back(h);
+    }
+    while(!worklist.empty()) {
+        eqbool e = worklist.back();
+        worklist.pop_back();
+        check(e);
+        e.propagate_impl();
+        if(&e.get_context() != this)
+            continue;
+
+        std::size_t i = e.get_id() / 2 - first_id;
+        if(live[i])
+            continue;
+
+        live[i] = true;
+        for(eqbool a : (e ^ e.is_inversion()).get_args())
+            worklist.push_back(a);
+    }
+
+    // Everything referring to the old nodes goes.
+    delete session;
+    session = nullptr;
+    term_nodes.clear();
+    implications.clear();
+    implication_order.clear();
+    sweep_position = base ? first_id : 1;
+
+    auto old_defs = std::move(defs);
+    defs.clear();
+    std::vector<eqbool> old_nodes;
+    old_nodes.swap(nodes);
+    std::fill(std::begin(num_nodes_by_kind), std::end(num_nodes_by_kind), 0);
+    num_args = 0;
+    num_arg_slots = 0;
+
+    eqfalse = get_or({});
+    eqtrue = ~eqfalse;
+
+    std::vector<eqbool> rebuilt(old_nodes.size());
+    auto translate = [&](eqbool e) {
+        e.propagate_impl();
+        if(&e.get_context() != this)
+            return e;
+        eqbool r = rebuilt[e.get_id() / 2 - first_id];
+        assert(r);
+        return r ^ e.is_inversion();
+    };
+
+    // Nodes only refer to and are only merged into nodes created
+    // before them, so rebuilding in order of creation always finds
+    // the arguments rebuilt.
+    std::vector<eqbool> args;
+    for(std::size_t i = 0; i != old_nodes.size(); ++i) {
+        if(!live[i])
+            continue;
+
+        const node_def &def = old_nodes[i].get_def();
+        if(def.kind == node_kind::term) {
+            rebuilt[i] = get(def.term);
+            continue;
+        }
+
+        args.clear();
+        for(eqbool a : def.args)
+            args.push_back(translate(a));
+        rebuilt[i] = rebuild(def.kind, args);
+    }
+
+    for(eqbool &h : handles) {
+        if(h) {
+            h = translate(h);
+            h.propagate();
+        }
+    }
+}
+
 void eqbool_context::store_equiv(eqbool a, eqbool b) {
     // Assume that the node created earlier is the simpler one.
     if(a < b)
@@ -592,15 +2209,181 @@ void eqbool_context::store_equiv(eqbool a, eqbool b) {
         b = ~b;
     }
 
+    // Nodes of the base context are never changed.
+    if(&a.get_context() != this)
+        return;
+
+    assert(!frozen);
     a.get_entry().second = b;
 }
 
+sat_job *eqbool_context::start_equiv_job(eqbool a, eqbool b, bool &equiv) {
+    check(a);
+    check(b);
+
+    eqbool eq = get_eq(a, b);
+    if(eq.is_const()) {
+        equiv = eq.is_true();
+        return nullptr;
+    }
+
+    auto *job = new sat_job;
+    job->a = a;
+    job->b = b;
+    if(prepare_sat_job(*job, ~eq, /* miter= */ true))
+        return job;
+
+    equiv = finish_sat_job(*job);
+    assert(equiv);
+    store_equiv(a, b);
+    delete job;
+    return nullptr;
+}
+
+void eqbool_context::submit_sat_job(sat_job *job) {
+    // Handle the checks completed so far, so they do not pile up
+    // for callers that only wait on futures.
+    apply_sat_jobs(/* wait= */ false);
+
+    if(!pool) {
+        unsigned n = num_sat_workers;
+        if(n == 0)
+            n = std::max(std::thread::hardware_concurrency(), 1u);
+        pool = new detail::sat_pool(n);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->pending.push_back(job);
+        ++pool->num_in_flight;
+    }
+    pool->pending_cv.notify_one();
+}
+
+void eqbool_context::apply_sat_jobs(bool wait) {
+    if(!pool)
+        return;
+
+    for(;;) {
+        std::deque<sat_job*> finished;
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            if(wait) {
+                pool->done_cv.wait(lock, [this]() {
+                    return !pool->done.empty() || pool->num_in_flight == 0; });
+            }
+            finished.swap(pool->done);
+            pool->num_in_flight -= finished.size();
+        }
+
+        if(finished.empty())
+            break;
+
+        for(sat_job *job : finished) {
+            ++stats.num_async_sat_solutions;
+            bool equiv = finish_sat_job(*job);
+            if(equiv) {
+                // The nodes may have been merged with others since.
+                eqbool a = job->a, b = job->b;
+                a.propagate();
+                b.propagate();
+                if(a != b)
+                    store_equiv(a, b);
+            }
+
+            // Callbacks may submit further checks.
+            std::function<void(bool)> callback = std::move(job->callback);
+            delete job;
+            if(callback)
+                callback(equiv);
+        }
+
+        if(!wait)
+            break;
+    }
+
+    // Apply a change in the number of workers once idle.
+    if(wait) {
+        unsigned n = num_sat_workers;
+        if(n == 0)
+            n = std::max(std::thread::hardware_concurrency(), 1u);
+        if(n != pool->workers.size()) {
+            delete pool;
+            pool = nullptr;
+        }
+    }
+}
+
+std::future<bool> eqbool_context::is_equiv_async(eqbool a, eqbool b) {
+    bool equiv = false;
+    sat_job *job = start_equiv_job(a, b, equiv);
+    if(!job) {
+        std::promise<bool> promise;
+        promise.set_value(equiv);
+        return promise.get_future();
+    }
+
+    job->promise.reset(new std::promise<bool>);
+    std::future<bool> future = job->promise->get_future();
+    submit_sat_job(job);
+    return future;
+}
+
+void eqbool_context::is_equiv_async(eqbool a, eqbool b,
+                                    std::function<void(bool)> callback) {
+    bool equiv = false;
+    sat_job *job = start_equiv_job(a, b, equiv);
+    if(!job) {
+        // Decided without SAT, so complete right away.
+        callback(equiv);
+        return;
+    }
+
+    job->callback = std::move(callback);
+    submit_sat_job(job);
+}
+
+eqbool eqbool_context::get_eq(eqbool a, eqbool b) {
+    if(start_recording()) {
+        eqbool r = get_eq(a, b);
+        recorder->busy = false;
+        recorder->record_eq(a, b, r);
+        return r;
+    }
+
+    if(start_measuring()) {
+        auto start = std::chrono::steady_clock::now();
+        eqbool r = get_eq(a, b);
+        finish_measuring(stats.latencies.get_eq, start);
+        return r;
+    }
+
+    // XOR gates take the same number of clauses with the same
+    // number of literals as IFELSE gates, so it doesn't make sense
+    // to have special support for them.
+    return ifelse(a, b, ~b);
+}
+
 bool eqbool_context::is_equiv(eqbool a, eqbool b) {
+    if(start_recording()) {
+        bool equiv = is_equiv(a, b);
+        recorder->busy = false;
+        recorder->record_equiv(a, b, equiv);
+        return equiv;
+    }
+
+    if(start_measuring()) {
+        auto start = std::chrono::steady_clock::now();
+        bool equiv = is_equiv(a, b);
+        finish_measuring(stats.latencies.is_equiv, start);
+        return equiv;
+    }
+
     eqbool eq = get_eq(a, b);
     if(eq.is_const())
         return eq.is_true();
 
-    bool equiv = is_unsat(~eq);
+    bool equiv = is_unsat(~eq, /* miter= */ true);
 
     if(equiv)
         store_equiv(a, b);
@@ -608,6 +2391,48 @@ bool eqbool_context::is_equiv(eqbool a, eqbool b) {
     return equiv;
 }
 
+memory_stats eqbool_context::get_memory_stats() const {
+    memory_stats ms;
+
+    // Entries of the node table are allocated along with a link
+    // and the cached hash.
+    std::size_t entry_size = sizeof(std::pair<const node_def, eqbool>) +
+                             2 * sizeof(void*);
+    std::copy(std::begin(num_nodes_by_kind), std::end(num_nodes_by_kind),
+              std::begin(ms.num_nodes));
+    ms.node_bytes = defs.size() * entry_size;
+
+    ms.num_args = num_args;
+    ms.num_arg_slots = num_arg_slots;
+    ms.arg_bytes = num_arg_slots * sizeof(eqbool);
+
+    ms.num_buckets = defs.bucket_count();
+    ms.load_factor = defs.load_factor();
+    ms.bucket_bytes = defs.bucket_count() * sizeof(void*);
+
+    ms.index_bytes = nodes.capacity() * sizeof(eqbool) +
+                     term_nodes.capacity() * sizeof(eqbool);
+
+    std::size_t implication_entry_size =
+        sizeof(decltype(implications)::value_type) + 2 * sizeof(void*);
+    for(const auto &i : implications) {
+        ms.num_learned_implications += i.second.size();
+        ms.implication_bytes += implication_entry_size +
+                                i.second.capacity() * sizeof(eqbool);
+    }
+    ms.implication_bytes += implications.bucket_count() * sizeof(void*);
+    ms.implication_bytes += implication_order.size() *
+                            sizeof(implication_order[0]);
+
+    // Overlays share the terms of their bases.
+    if(!base)
+        ms.terms = terms.get_memory_stats();
+
+    ms.total_bytes = ms.node_bytes + ms.arg_bytes + ms.bucket_bytes +
+                     ms.index_bytes + ms.implication_bytes + ms.terms.bytes;
+    return ms;
+}
+
 std::ostream &eqbool_context::print_helper(
         std::ostream &s, eqbool e, bool subexpr,
         const std::unordered_map<const node_def*, unsigned> &ids,
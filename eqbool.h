@@ -11,18 +11,32 @@
 #ifndef EQBOOL_H
 #define EQBOOL_H
 
+// Nonzero to collect the hot-path counters and timers of
+// eqbool_stats. Has to be the same for the library and its users.
+#ifndef EQBOOL_COUNTERS
+#define EQBOOL_COUNTERS 0
+#endif
+
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
 #include <initializer_list>
+#include <iosfwd>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace eqbool {
 
 class args_ref;
+class call_recorder;
 class eqbool;
 class eqbool_context;
 
@@ -58,17 +72,69 @@ public:
         total += delta.count();
         start = now;
     }
+
+    // Drops the time since the last update.
+    void skip() {
+        start = std::chrono::steady_clock::now();
+    }
+};
+
+// Timers that do not count the time of the timers nested in
+// them, so that every interval is only counted once.
+class nested_timer {
+private:
+    nested_timer *&innermost;
+    nested_timer *outer;
+    timer t;
+
+public:
+    nested_timer(nested_timer *&innermost, double &total)
+            : innermost(innermost), outer(innermost), t(total) {
+        if(outer)
+            outer->t.update();
+        innermost = this;
+    }
+
+    ~nested_timer() {
+        t.update();
+        innermost = outer;
+        if(outer)
+            outer->t.skip();
+    }
+
+    nested_timer(const nested_timer &) = delete;
+    nested_timer &operator = (const nested_timer &) = delete;
 };
 
 enum class node_kind { term, or_node, ifelse, eq };
 
+// How much work to do simplifying nodes as they are built. The
+// fast level only does hash-consing and folds constants and
+// directly repeated or complementary arguments. The strong level
+// additionally cancels out repeated leaves of EQ chains.
+enum class effort_level { fast, normal, strong };
+
 namespace detail {
 
+constexpr bool counters_enabled = EQBOOL_COUNTERS != 0;
+
+class null_timer {
+public:
+    null_timer(nested_timer *&, double &) {}
+};
+
+// Hot-path timers, only active if counters are enabled.
+using scoped_timer = std::conditional<counters_enabled, nested_timer,
+                                      null_timer>::type;
+
 constexpr uintptr_t inversion_flag = 1;
 constexpr uintptr_t lock_flag = 2;
 constexpr uintptr_t entry_code_mask = ~(inversion_flag | lock_flag);
 
 struct node_def;
+struct sat_job;
+struct sat_pool;
+struct sat_session;
 
 struct hasher {
     template <class T>
@@ -110,10 +176,21 @@ struct node_def {
 
 }  // namespace detail
 
+struct term_memory_stats {
+    std::size_t num_terms = 0;
+    std::size_t bytes = 0;
+};
+
 class term_set_base {
 public:
     virtual ~term_set_base();
     virtual std::ostream &print(std::ostream &s, uintptr_t t) const = 0;
+
+    // Whether the terms are numbered densely from zero, so that
+    // contexts can look up their nodes by index.
+    virtual bool has_dense_codes() const { return false; }
+
+    virtual term_memory_stats get_memory_stats() const { return {}; }
 };
 
 template<typename T>
@@ -131,8 +208,62 @@ public:
     std::ostream &print(std::ostream &s, uintptr_t t) const override {
         return s << *reinterpret_cast<T*>(t);
     }
+
+    // Does not include memory the terms own.
+    term_memory_stats get_memory_stats() const override {
+        term_memory_stats stats;
+        stats.num_terms = terms.size();
+        stats.bytes = terms.size() * (sizeof(T) + 2 * sizeof(void*)) +
+                      terms.bucket_count() * sizeof(void*);
+        return stats;
+    }
 };
 
+// Terms named by strings, numbered in order of addition. The names
+// are kept in a single buffer and looked up in an open-addressing
+// table of term numbers.
+class term_table : public term_set_base {
+private:
+    std::string names;
+
+    // Where the names start, followed by the end of the last one.
+    std::vector<std::size_t> offsets = {0};
+
+    // Term numbers plus one; zeros mark free slots.
+    std::vector<uintptr_t> slots;
+
+    static std::size_t hash(const char *name, std::size_t len);
+    bool matches(uintptr_t t, const char *name, std::size_t len) const;
+    void grow();
+
+public:
+    term_table() = default;
+
+    uintptr_t add(const char *name, std::size_t len);
+    uintptr_t add(const std::string &name) {
+        return add(name.data(), name.size());
+    }
+
+    std::size_t size() const { return offsets.size() - 1; }
+
+    std::string get_name(uintptr_t t) const {
+        return names.substr(offsets[t], offsets[t + 1] - offsets[t]);
+    }
+
+    std::ostream &print(std::ostream &s, uintptr_t t) const override;
+
+    bool has_dense_codes() const override { return true; }
+
+    term_memory_stats get_memory_stats() const override;
+};
+
+namespace detail {
+
+// Nodes of overlay contexts can be mixed with nodes of their bases.
+bool are_compatible(const eqbool_context &a, const eqbool_context &b);
+
+}  // namespace detail
+
 class eqbool {
 private:
     using node_def = detail::node_def;
@@ -149,8 +280,19 @@ private:
         assert(!(entry_code & detail::inversion_flag));
     }
 
+    // Follows the chain of equivalences. Does not change anything
+    // in the context.
+    static uintptr_t follow(uintptr_t entry_code, unsigned long &num_steps);
+
     void propagate_impl();
 
+    // Like propagate(), but without reducing the node, so that
+    // nodes of contexts used by other threads can be looked at.
+    eqbool resolve() const {
+        unsigned long num_steps = 0;
+        return eqbool(follow(entry_code, num_steps));
+    }
+
     void reduce();
 
 public:
@@ -241,7 +383,7 @@ public:
     bool is_const() const { return get_id() < 2; }
 
     bool operator == (const eqbool &other) const {
-        assert(&get_context() == &other.get_context());
+        assert(detail::are_compatible(get_context(), other.get_context()));
         return entry_code == other.entry_code;
     }
 
@@ -250,7 +392,7 @@ public:
     }
 
     bool operator < (const eqbool &other) const {
-        assert(&get_context() == &other.get_context());
+        assert(detail::are_compatible(get_context(), other.get_context()));
         return get_id() < other.get_id();
     }
 
@@ -290,48 +432,392 @@ public:
     const eqbool *end() const { return data() + size(); }
 };
 
+// Solver settings for queries that do not fit the built-in solver.
+// The context uses the first profile that accepts the query and
+// CaDiCaL defaults if none does.
+struct sat_profile {
+    std::string name;
+
+    // One of CaDiCaL's configurations: "default", "plain", "sat" or
+    // "unsat".
+    std::string config = "default";
+
+    // CaDiCaL options to set on top of the configuration.
+    std::vector<std::pair<std::string, int>> options;
+
+    // Queries of more clauses are not accepted.
+    unsigned long max_clauses = ~0ul;
+
+    // Queries are only accepted once at least this portion of
+    // previous queries of the same kind (equivalence miters or
+    // other) turned out to be unsatisfiable.
+    double min_unsat_ratio = 0;
+};
+
+// Clauses in DIMACS literals, stored flat and terminated with zeros.
+struct cnf {
+    std::vector<int> lits;
+    unsigned long num_clauses = 0;
+    int num_vars = 0;
+
+    void add(int lit) {
+        lits.push_back(lit);
+        if(lit == 0)
+            ++num_clauses;
+        else
+            num_vars = std::max(num_vars, lit < 0 ? -lit : lit);
+    }
+
+    // Comments are skipped. Returns false if the input is
+    // malformed or incomplete.
+    bool read_dimacs(std::istream &s);
+
+    std::ostream &write_dimacs(std::ostream &s) const;
+};
+
+// Counts of durations in buckets of logarithmically growing widths,
+// so that the percentiles are within about 3% of the actual values
+// regardless of the magnitude.
+class latency_histogram {
+private:
+    // Every power of two is split into this many buckets.
+    static constexpr unsigned sub_bucket_bits = 5;
+    static constexpr std::uint64_t num_sub_buckets = 1u << sub_bucket_bits;
+
+    std::vector<unsigned long> counts;
+    unsigned long count = 0;
+    std::uint64_t max = 0;
+
+    static std::size_t get_bucket(std::uint64_t ns);
+
+    // The largest duration the bucket can hold.
+    static std::uint64_t get_bucket_limit(std::size_t bucket);
+
+public:
+    void add(std::uint64_t ns);
+    void merge(const latency_histogram &other);
+
+    unsigned long get_count() const { return count; }
+    std::uint64_t get_max() const { return max; }
+
+    // The duration p percent of the samples do not exceed.
+    std::uint64_t get_percentile(double p) const;
+};
+
+// Only collected if enabled with set_latency_recording().
+struct latency_stats {
+    latency_histogram get;
+    latency_histogram get_or;
+    latency_histogram ifelse;
+    latency_histogram get_eq;
+    latency_histogram is_equiv;
+};
+
+// Estimates; allocator overhead is not included. For overlays,
+// only the nodes created in the overlay are counted.
+struct memory_stats {
+    // By node kind.
+    std::size_t num_nodes[4] = {};
+    std::size_t node_bytes = 0;
+
+    // Arguments of all nodes and the space reserved for them.
+    std::size_t num_args = 0;
+    std::size_t num_arg_slots = 0;
+    std::size_t arg_bytes = 0;
+
+    std::size_t num_buckets = 0;
+    float load_factor = 0;
+    std::size_t bucket_bytes = 0;
+
+    // Lists of nodes in order of creation and by terms.
+    std::size_t index_bytes = 0;
+
+    std::size_t num_learned_implications = 0;
+    std::size_t implication_bytes = 0;
+
+    term_memory_stats terms;
+
+    std::size_t total_bytes = 0;
+
+    std::size_t get_num_nodes(node_kind kind) const {
+        return num_nodes[static_cast<int>(kind)];
+    }
+};
+
+struct sat_profile_stats {
+    double sat_time = 0;
+    unsigned long num_sat_solutions = 0;
+    unsigned long num_unsat = 0;
+};
+
+struct sweep_result {
+    double time = 0;
+    unsigned long num_merged = 0;
+    unsigned long num_sat_calls = 0;
+
+    // Whether all nodes have been looked at within the budget.
+    bool complete = false;
+};
+
+// Values to substitute for terms. Also keeps the results for the
+// nodes rebuilt so far, so that substitutions done with the same
+// values, e.g., within a simulation cycle, reuse each other's work.
+class substitution {
+private:
+    std::unordered_map<uintptr_t, eqbool> values;
+    std::unordered_map<uintptr_t, eqbool> rebuilt;
+
+public:
+    substitution() = default;
+
+    // Drops the kept results.
+    void set(uintptr_t term, eqbool value) {
+        values[term] = value;
+        rebuilt.clear();
+    }
+
+    void clear() {
+        values.clear();
+        rebuilt.clear();
+    }
+
+    friend class eqbool_context;
+};
+
+// Nodes of another context imported so far and the terms to
+// use in place of the terms of that context. Terms not mapped are
+// imported as they are, which is what contexts sharing the same
+// term set need.
+class import_map {
+private:
+    const eqbool_context *src = nullptr;
+    std::unordered_map<uintptr_t, eqbool> nodes;
+    std::unordered_map<uintptr_t, uintptr_t> terms;
+
+public:
+    import_map() = default;
+
+    // Drops the imported nodes.
+    void map_term(uintptr_t src_term, uintptr_t term) {
+        terms[src_term] = term;
+        nodes.clear();
+    }
+
+    void clear() {
+        src = nullptr;
+        nodes.clear();
+        terms.clear();
+    }
+
+    friend class eqbool_context;
+};
+
 struct eqbool_stats {
     double sat_time = 0;
     double clauses_time = 0;
+    double xor_time = 0;
+
+    // Solver calls. Queries refuted by Gaussian elimination are
+    // counted as XOR refutations instead.
     unsigned long num_sat_solutions = 0;
+    unsigned long num_small_sat_solutions = 0;
+    unsigned long num_assumption_sat_solutions = 0;
+    unsigned long num_async_sat_solutions = 0;
+    unsigned long num_learned_implications = 0;
+    unsigned long num_implication_hits = 0;
+    unsigned long num_xor_refutations = 0;
+    unsigned long num_xor_clauses = 0;
+    double sweep_time = 0;
+    unsigned long num_swept_merges = 0;
+    unsigned long num_captured_queries = 0;
     unsigned long num_clauses = 0;
+
+    // Indexed as the context's SAT profiles.
+    std::vector<sat_profile_stats> sat_profiles;
+
+    // Only collected if EQBOOL_COUNTERS is nonzero.
+    struct hot_path_stats {
+        // Node table lookups, by the number of entries in the
+        // buckets looked up.
+        unsigned long num_lookups = 0;
+        unsigned long num_lookup_probes = 0;
+        unsigned long num_lookup_hits = 0;
+        unsigned long num_base_lookup_hits = 0;
+        unsigned long num_inserts = 0;
+
+        unsigned long num_reductions = 0;
+        unsigned long num_reduction_rounds = 0;
+        unsigned long num_evaluations = 0;
+        unsigned long num_evaluation_rounds = 0;
+
+        // Walks along chains of merged nodes.
+        unsigned long num_propagations = 0;
+        unsigned long num_propagation_steps = 0;
+
+        // Simplification rules.
+        unsigned long num_constant_folds = 0;
+        unsigned long num_subsumptions = 0;
+        unsigned long num_ifelse_recognitions = 0;
+        unsigned long num_eq_cancellations = 0;
+
+        // Exclusive times. Reductions are part of building nodes
+        // and evaluations are part of reductions.
+        double build_time = 0;
+        double reduce_time = 0;
+        double evaluate_time = 0;
+    };
+
+    hot_path_stats hot;
+
+    latency_stats latencies;
 };
 
 class eqbool_context {
 private:
     using node_def = detail::node_def;
 
+    // The frozen context this one is an overlay of.
+    const eqbool_context *base = nullptr;
+    bool frozen = false;
+
     std::unordered_map<node_def, eqbool, detail::hasher, detail::matcher> defs;
 
+    // Nodes in order of creation.
+    std::vector<eqbool> nodes;
+
+    // Maintained as nodes are created, see get_memory_stats().
+    std::size_t num_nodes_by_kind[4] = {};
+    std::size_t num_args = 0;
+    std::size_t num_arg_slots = 0;
+
     const term_set_base &terms;
 
+    // Nodes of terms by their numbers, for dense term sets.
+    bool dense_terms = false;
+    std::vector<eqbool> term_nodes;
+
     eqbool_stats stats;
+    nested_timer *innermost_timer = nullptr;
+
+    // Queries of up to this number of clauses are solved with the
+    // built-in solver rather than CaDiCaL.
+    unsigned long small_sat_threshold = default_small_sat_threshold;
+
+    std::vector<sat_profile> sat_profiles = get_default_sat_profiles();
+
+    struct sat_history {
+        unsigned long num_queries = 0;
+        unsigned long num_unsat = 0;
+    };
+
+    sat_history miter_history, other_history;
+
+    detail::sat_session *session = nullptr;
+
+    // Zero means the number of hardware threads.
+    unsigned num_sat_workers = 0;
+    detail::sat_pool *pool = nullptr;
+
+    call_recorder *recorder = nullptr;
+
+    // Where to write SAT queries that take at least the specified
+    // time. Empty if not capturing.
+    std::string capture_dir;
+    double capture_min_time = 0;
+
+    // Whether to record latencies of top-level calls and whether a
+    // measured call is in progress.
+    bool latency_recording = false;
+    bool measuring = false;
+
+    // Implications proven by SAT, keyed by entry codes of their
+    // premises. Evicted in order of learning.
+    std::unordered_map<uintptr_t, std::vector<eqbool>> implications;
+    std::deque<std::pair<eqbool, eqbool>> implication_order;
+    std::size_t max_implications = default_max_implications;
+
+    bool xor_reasoning = true;
+
+    effort_level effort = effort_level::normal;
+
+    // The id of the first node the next sweep is to look at.
+    std::size_t sweep_position = 1;
 
     eqbool eqfalse = get_or({});
     eqbool eqtrue = ~eqfalse;
 
     eqbool add_def(node_def def);
 
+    static void count(unsigned long &counter) {
+        if(detail::counters_enabled)
+            ++counter;
+    }
+
     void check(eqbool e) const {
         unused(&e);
-        assert(&e.get_context() == this);
+        assert(detail::are_compatible(e.get_context(), *this));
+    }
+
+    // The id of the first node created in this context.
+    std::size_t get_first_id() const {
+        return base ? base->defs.size() : 0;
     }
 
     int skip_not(eqbool &e,
                  std::unordered_map<const node_def*, int> &literals);
 
+    // Adds clauses for the nodes in the cone of e that are not
+    // visited yet. Returns the literal of e.
+    int encode(cnf &clauses, eqbool e,
+               std::unordered_map<const node_def*, int> &literals,
+               std::unordered_set<const node_def*> &visited);
+
+    // Treats the EQ nodes in the encoded cone as XOR constraints
+    // and adds the units and equivalences Gaussian elimination
+    // derives from them. Returns false if the constraints are
+    // inconsistent.
+    bool add_xor_clauses(cnf &clauses, int root_lit,
+                         std::unordered_map<const node_def*, int> &literals,
+                         const std::unordered_set<const node_def*> &visited);
+
+    // Folds e to a constant if it is the assumed false node or
+    // its inversion.
+    eqbool fold(eqbool assumed_false, eqbool e) const;
+
+    // Rebuilds the EQ chain of a and b with the leaves that occur
+    // in it an even number of times removed. Returns an undefined
+    // node if there are no such leaves.
+    eqbool cancel_eq_leaves(eqbool a, eqbool b);
+
+    // Builds a node of the specified kind. The arguments have to
+    // be in the same form as in node definitions.
+    eqbool rebuild(node_kind kind, args_ref args);
+
+    eqbool substitute_impl(eqbool e, substitution &subst);
+    eqbool import_impl(eqbool e, import_map &map);
+
     eqbool get_value(std::vector<eqbool> &eqs, eqbool assumed_false) const;
 
     static void add_eq(std::vector<eqbool> &eqs, eqbool e);
 
+    eqbool get_implied_value(const std::vector<eqbool> &eqs,
+                             eqbool premise);
+
+    void learn_implication(eqbool a, eqbool b);
+    void forget_implication();
+
+    // is_sat_under() without learning implications, for queries
+    // whose results are recorded otherwise.
+    bool solve_under(eqbool e, args_ref assumptions);
+
     eqbool evaluate(args_ref assumed_falses, const eqbool &excluded,
-                    std::vector<eqbool> &eqs) const;
+                    std::vector<eqbool> &eqs);
 
     eqbool evaluate(args_ref assumed_falses, const eqbool &excluded,
-                    eqbool e, std::vector<eqbool> &eqs) const;
+                    eqbool e, std::vector<eqbool> &eqs);
 
     eqbool evaluate(args_ref assumed_falses, const eqbool &excluded,
-                    eqbool e) const;
+                    eqbool e);
 
     static bool contains_all(args_ref p, args_ref q);
 
@@ -342,6 +828,40 @@ private:
 
     eqbool ifelse_impl(eqbool i, eqbool t, eqbool e);
 
+    std::size_t select_sat_profile(unsigned long num_clauses,
+                                   const sat_history &history) const;
+
+    // Encodes the query. Returns false if it is refuted by the XOR
+    // reasoning already.
+    bool prepare_sat_job(detail::sat_job &job, eqbool e, bool miter);
+
+    // Only touches the job, so can run on any thread.
+    static void run_sat_job(detail::sat_job &job);
+
+    // Returns whether e is unsatisfiable.
+    bool finish_sat_job(detail::sat_job &job);
+
+    // Returns the job to submit or null if the check is decided
+    // right away.
+    detail::sat_job *start_equiv_job(eqbool a, eqbool b, bool &equiv);
+    void submit_sat_job(detail::sat_job *job);
+    void apply_sat_jobs(bool wait);
+
+    bool is_unsat(eqbool e, bool miter);
+
+    void capture_query(const detail::sat_job &job);
+
+    // Returns whether the call in progress is to be recorded. If
+    // so, the calls it makes are not recorded until the recorder
+    // is released.
+    bool start_recording();
+
+    // Same for measuring latencies of calls.
+    bool start_measuring();
+    void finish_measuring(
+        latency_histogram &h,
+        std::chrono::time_point<std::chrono::steady_clock> start);
+
     void store_equiv(eqbool a, eqbool b);
 
     std::ostream &print_helper(std::ostream &s, eqbool e, bool subexpr,
@@ -353,9 +873,42 @@ private:
     std::ostream &dump(std::ostream &s, args_ref nodes) const;
 
     friend eqbool;
+    friend detail::sat_pool;
 
 public:
-    eqbool_context(const term_set_base &terms) : terms(terms) {}
+    static constexpr unsigned long default_small_sat_threshold = 100;
+    static constexpr std::size_t default_max_implications = 4096;
+
+    eqbool_context(const term_set_base &terms)
+            : terms(terms), dense_terms(terms.has_dense_codes()) {
+        stats.sat_profiles.resize(sat_profiles.size());
+    }
+
+    // Creates an overlay of a frozen context. Overlays look up
+    // nodes in their base first and only create the nodes missing
+    // there, so any number of them, e.g., one per thread, can
+    // share the same base. Nodes of the base come before the nodes
+    // of the overlay in the canonical order. The base has to
+    // outlive its overlays.
+    explicit eqbool_context(const eqbool_context *base);
+
+    eqbool_context(const eqbool_context &) = delete;
+    eqbool_context &operator = (const eqbool_context &) = delete;
+
+    ~eqbool_context();
+
+    // Makes the context immutable so it can be used as the base of
+    // overlay contexts concurrently. Nodes of frozen contexts are
+    // not to be combined with each other other than via methods of
+    // their overlays. Completes the pending asynchronous checks
+    // first.
+    void freeze() {
+        sync();
+        frozen = true;
+    }
+    bool is_frozen() const { return frozen; }
+
+    const eqbool_context *get_base() const { return base; }
 
     eqbool get_false() { return eqfalse; }
     eqbool get_true() { return eqtrue; }
@@ -370,22 +923,146 @@ public:
     eqbool get_and(eqbool a, eqbool b) { return get_and({a, b}); }
     eqbool ifelse(eqbool i, eqbool t, eqbool e);
 
-    eqbool get_eq(eqbool a, eqbool b) {
-        // XOR gates take the same number of clauses with the
-        // same number of literals as IFELSE gates, so it doesn't
-        // make sense to have special support for them.
-        return ifelse(a, b, ~b);
-    }
+    eqbool get_eq(eqbool a, eqbool b);
 
     const eqbool_stats &get_stats() const { return stats; }
 
+    // Writes every SAT query that takes at least min_time seconds
+    // to the specified existing directory as a DIMACS file,
+    // query-N.cnf, with the variables, the query expression and
+    // the time in comments. Queries are numbered per process.
+    // Queries under assumptions are not captured. An empty
+    // directory stops capturing.
+    void set_query_capture(std::string dir, double min_time) {
+        capture_dir = std::move(dir);
+        capture_min_time = min_time;
+    }
+
+    static std::string get_capture_path(const std::string &dir,
+                                        unsigned long n) {
+        return dir + "/query-" + std::to_string(n) + ".cnf";
+    }
+
+    // Solves the clauses with CaDiCaL as configured by the profile
+    // regardless of its limits.
+    static bool is_unsat(const cnf &clauses, const sat_profile &profile);
+
+    memory_stats get_memory_stats() const;
+
+    unsigned long get_small_sat_threshold() const {
+        return small_sat_threshold;
+    }
+
+    void set_small_sat_threshold(unsigned long n) {
+        small_sat_threshold = n;
+    }
+
+    static std::vector<sat_profile> get_default_sat_profiles();
+
+    // Whether CaDiCaL accepts the configuration and the options of
+    // the profile.
+    static bool is_valid_sat_profile(const sat_profile &profile);
+
+    const std::vector<sat_profile> &get_sat_profiles() const {
+        return sat_profiles;
+    }
+
+    // The profiles are expected to be valid. Also resets the
+    // per-profile statistics.
+    void set_sat_profiles(std::vector<sat_profile> profiles);
+
+    std::size_t get_max_learned_implications() const {
+        return max_implications;
+    }
+
+    // Zero disables learning.
+    void set_max_learned_implications(std::size_t n);
+
+    bool get_xor_reasoning() const { return xor_reasoning; }
+    void set_xor_reasoning(bool enabled) { xor_reasoning = enabled; }
+
+    effort_level get_effort() const { return effort; }
+
+    // Only affects nodes built after the change.
+    void set_effort(effort_level level) { effort = level; }
+
     bool is_trivially_equiv(eqbool a, eqbool b) {
         return get_eq(a, b).is_true();
     }
 
-    bool is_unsat(eqbool e);
+    bool is_unsat(eqbool e) { return is_unsat(e, /* miter= */ false); }
     bool is_equiv(eqbool a, eqbool b);
 
+    // Asynchronous equivalence checks. The clauses are generated
+    // on the calling thread and then solved by a pool of worker
+    // threads owned by the context. Proven equivalences are only
+    // recorded and callbacks are only invoked by sync(), poll() and
+    // further submissions, on the thread that owns the context.
+    // Checks decided without the SAT solver complete right away.
+    // Futures become ready as soon as the solver finishes, but the
+    // completed checks stay with the context and the equivalences
+    // are not recorded until one of these calls handles them.
+    std::future<bool> is_equiv_async(eqbool a, eqbool b);
+    void is_equiv_async(eqbool a, eqbool b,
+                        std::function<void(bool)> callback);
+
+    // Waits for all submitted checks to complete.
+    void sync() { apply_sat_jobs(/* wait= */ true); }
+
+    // Only handles the checks already completed.
+    void poll() { apply_sat_jobs(/* wait= */ false); }
+
+    unsigned get_num_sat_workers() const { return num_sat_workers; }
+
+    // Takes effect on the next submission after a sync().
+    void set_num_sat_workers(unsigned n) { num_sat_workers = n; }
+
+    // Queries under assumptions neither create nor simplify nodes.
+    // Their clauses are kept in a solver that persists between the
+    // queries, so every node is only encoded once.
+    bool is_sat_under(eqbool e, args_ref assumptions);
+    bool implies(eqbool a, eqbool b) { return !is_sat_under(~b, {a}); }
+
+    // Looks for functionally equivalent nodes by comparing their
+    // values on random inputs, proves the candidates with SAT in
+    // order of creation and merges the equivalent ones. Stops after
+    // the specified number of SAT calls; the next sweep then
+    // continues from where this one stopped, so sweeping can be
+    // interleaved with construction of new nodes.
+    sweep_result sweep(unsigned long max_sat_calls = ~0ul);
+
+    // Rebuilds e with the terms replaced with the given values.
+    eqbool substitute(eqbool e, substitution &subst);
+    void substitute(std::vector<eqbool> &roots, substitution &subst);
+
+    // Copies nodes from another context. Keeping the map between
+    // calls makes every node to be only translated once. The source
+    // context is not changed, so several threads can import from
+    // the same context.
+    eqbool import(const eqbool_context &src, eqbool e, import_map &map);
+    void import(const eqbool_context &src, std::vector<eqbool> &roots,
+                import_map &map);
+
+    // Rebuilds the nodes reachable from the handles, so that only
+    // canonical nodes with canonical arguments remain, renumbered
+    // densely in the canonical order, and updates the handles.
+    // All other nodes of the context, including those kept in
+    // substitutions and import maps, become invalid.
+    void compact(std::vector<eqbool> &handles);
+
+    // Records calls made to the context, see call_recorder. A
+    // recorder can be shared by a context and its overlay. Null
+    // stops recording. Not to be combined with compact().
+    call_recorder *get_recorder() const { return recorder; }
+    void set_recorder(call_recorder *r) { recorder = r; }
+
+    // Measures latencies of the get(), get_or(), ifelse(), get_eq()
+    // and is_equiv() calls, see eqbool_stats::latencies. Calls made
+    // by other methods, including these, are not measured
+    // separately.
+    bool get_latency_recording() const { return latency_recording; }
+    void set_latency_recording(bool enabled) { latency_recording = enabled; }
+
     std::ostream &print(std::ostream &s, eqbool e) const;
 };
 
@@ -398,12 +1075,19 @@ inline args_ref eqbool::get_args() const {
     return get_def().args;
 }
 
+inline bool detail::are_compatible(const eqbool_context &a,
+                                   const eqbool_context &b) {
+    return &a == &b || a.get_base() == &b || b.get_base() == &a;
+}
+
 inline eqbool eqbool::operator | (eqbool other) const {
-    return get_context().get_or(*this, other);
+    eqbool_context &c = get_context();
+    return (c.is_frozen() ? other.get_context() : c).get_or(*this, other);
 }
 
 inline eqbool eqbool::operator & (eqbool other) const {
-    return get_context().get_and(*this, other);
+    eqbool_context &c = get_context();
+    return (c.is_frozen() ? other.get_context() : c).get_and(*this, other);
 }
 
 inline std::ostream &eqbool::print(std::ostream &s) const {
@@ -229,3 +229,23 @@ class Context(_Context):
     def is_equiv(self, a: Bool, b: Bool) -> bool:
         assert all(a.context is self for a in (a, b))
         return self._is_equiv(a._p, b._p)
+
+    def implies(self, a: Bool, b: Bool) -> bool:
+        assert all(a.context is self for a in (a, b))
+        return self._implies(a._p, b._p)
+
+    def is_sat_under(self, e: Bool, *assumptions: Bool) -> bool:
+        assert e.context is self
+        assert all(a.context is self for a in assumptions)
+        return self._is_sat_under(e._p, *(a._p for a in assumptions))
+
+    def substitute(self, roots: list[Bool],
+                   values: dict[Bool, Bool]) -> list[Bool]:
+        assert all(e.context is self for e in roots)
+        assert all(t.is_term and v.context is self
+                   for t, v in values.items())
+
+        # Rebuilt nodes are shared between the roots.
+        pairs = tuple(p for t, v in values.items() for p in (t._p, v._p))
+        return [self._make(p)
+                for p in self._substitute(pairs, *(e._p for e in roots))]
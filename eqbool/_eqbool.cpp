@@ -72,6 +72,9 @@ static PyObject *context_get_or(PyObject *self, PyObject *args);
 static PyObject *context_ifelse(PyObject *self, PyObject *args);
 static PyObject *context_get_eq(PyObject *self, PyObject *args);
 static PyObject *context_is_equiv(PyObject *self, PyObject *args);
+static PyObject *context_implies(PyObject *self, PyObject *args);
+static PyObject *context_is_sat_under(PyObject *self, PyObject *args);
+static PyObject *context_substitute(PyObject *self, PyObject *args);
 
 static PyMethodDef context_methods[] = {
     {"_get_id", bool_get_id, METH_O, nullptr},
@@ -85,6 +88,9 @@ static PyMethodDef context_methods[] = {
     {"_ifelse", context_ifelse, METH_VARARGS, nullptr},
     {"_get_eq", context_get_eq, METH_VARARGS, nullptr},
     {"_is_equiv", context_is_equiv, METH_VARARGS, nullptr},
+    {"_implies", context_implies, METH_VARARGS, nullptr},
+    {"_is_sat_under", context_is_sat_under, METH_VARARGS, nullptr},
+    {"_substitute", context_substitute, METH_VARARGS, nullptr},
     {}  // Sentinel.
 };
 
@@ -321,6 +327,85 @@ static PyObject *context_is_equiv(PyObject *self, PyObject *args) {
     Py_RETURN_FALSE;
 }
 
+static PyObject *context_implies(PyObject *self, PyObject *args) {
+    std::vector<eqbool::eqbool> v;
+    if(!get_args(v, args))
+        return nullptr;
+
+    if(v.size() != 2) {
+        PyErr_SetString(PyExc_TypeError, "Expected exactly 2 arguments");
+        return nullptr;
+    }
+
+    auto &context = context_object::from_pyobject(self)->context;
+    if(context.implies(v[0], v[1]))
+        Py_RETURN_TRUE;
+
+    Py_RETURN_FALSE;
+}
+
+static PyObject *context_is_sat_under(PyObject *self, PyObject *args) {
+    std::vector<eqbool::eqbool> v;
+    if(!get_args(v, args))
+        return nullptr;
+
+    if(v.empty()) {
+        PyErr_SetString(PyExc_TypeError, "Expected at least 1 argument");
+        return nullptr;
+    }
+
+    auto &context = context_object::from_pyobject(self)->context;
+    std::vector<eqbool::eqbool> assumptions(v.begin() + 1, v.end());
+    if(context.is_sat_under(v[0], assumptions))
+        Py_RETURN_TRUE;
+
+    Py_RETURN_FALSE;
+}
+
+static PyObject *context_substitute(PyObject *self, PyObject *args) {
+    // The first argument is a tuple of terms and their values, the
+    // rest are the nodes to substitute them in.
+    Py_ssize_t num_args = PyTuple_Size(args);
+    PyObject *values = num_args > 0 ? PyTuple_GetItem(args, 0) : nullptr;
+    if(!values || !PyTuple_Check(values) || PyTuple_Size(values) % 2 != 0) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Expected a tuple of terms and values");
+        return nullptr;
+    }
+
+    std::vector<eqbool::eqbool> v;
+    if(!get_args(v, values))
+        return nullptr;
+
+    eqbool::substitution subst;
+    for(std::size_t i = 0; i != v.size(); i += 2) {
+        eqbool::eqbool term = v[i];
+        if(term.is_inversion() || term.get_kind() != eqbool::node_kind::term) {
+            PyErr_SetString(PyExc_TypeError, "Expected a term");
+            return nullptr;
+        }
+        subst.set(term.get_term(), v[i + 1]);
+    }
+
+    PyObject *list = PyList_New(num_args - 1);
+    if(!list)
+        return nullptr;
+
+    auto &context = context_object::from_pyobject(self)->context;
+    for(Py_ssize_t i = 1; i != num_args; ++i) {
+        eqbool::eqbool e = eqbool_from_pyobject(PyTuple_GetItem(args, i));
+        PyObject *r = pyobject_from_eqbool(context.substitute(e, subst));
+        if(!r) {
+            Py_DECREF(list);
+            return nullptr;
+        }
+
+        PyList_SET_ITEM(list, i - 1, r);
+    }
+
+    return list;
+}
+
 }  // anonymous namespace
 
 PyMODINIT_FUNC PyInit__eqbool(void);
@@ -31,3 +31,12 @@ class _Context:
 
     def _is_equiv(self, a: int, b: int) -> bool:
         ...
+
+    def _implies(self, a: int, b: int) -> bool:
+        ...
+
+    def _is_sat_under(self, e: int, *assumptions: int) -> bool:
+        ...
+
+    def _substitute(self, values: tuple[int, ...], *roots: int) -> list[int]:
+        ...
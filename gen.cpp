@@ -0,0 +1,578 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+// Generates tester traces for parameterised circuits, so that
+// scaling of the library can be measured on inputs of any size.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+[[noreturn]] static void fatal(std::string msg) {
+    std::cerr << msg << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+// Gate numbers times two plus the inversion flag.
+using lit = unsigned;
+using word = std::vector<lit>;
+
+enum class gate_kind { constant, input, and_gate, or_gate, ifelse, eq };
+
+enum assertion_kind { trivially_equal, equal, unequal, num_assertion_kinds };
+
+struct gen_options {
+    unsigned width = 8;
+    unsigned cycles = 4;
+    unsigned seed = 1;
+
+    // Relative frequencies of the kinds of assertions.
+    unsigned mix[num_assertion_kinds] = {1, 2, 1};
+};
+
+// Writes gates out as definitions as they are created. Also
+// simulates them on random inputs, which is how unequal outputs
+// are told from equal ones.
+class circuit {
+private:
+    static constexpr unsigned num_sim_words = 16;
+
+    struct gate {
+        gate_kind kind;
+        std::vector<lit> args;
+        std::string name;
+    };
+
+    std::ostream &out;
+    std::mt19937_64 &rng;
+    std::vector<gate> gates;
+
+    // num_sim_words words per gate.
+    std::vector<std::uint64_t> values;
+
+    const std::uint64_t *get_values(lit a) const {
+        return &values[a / 2 * num_sim_words];
+    }
+
+    lit add(gate_kind kind, std::vector<lit> args, std::string name) {
+        lit r = static_cast<lit>(gates.size() * 2);
+        std::uint64_t v[num_sim_words] = {};
+        for(unsigned i = 0; i != num_sim_words; ++i) {
+            auto arg = [&](unsigned n) {
+                lit a = args[n];
+                return get_values(a)[i] ^ (a & 1 ? ~std::uint64_t(0) : 0);
+            };
+            switch(kind) {
+            case gate_kind::constant:
+                break;
+            case gate_kind::input:
+                v[i] = rng();
+                break;
+            case gate_kind::and_gate:
+                v[i] = arg(0) & arg(1);
+                break;
+            case gate_kind::or_gate:
+                v[i] = arg(0) | arg(1);
+                break;
+            case gate_kind::ifelse:
+                v[i] = (arg(0) & arg(1)) | (~arg(0) & arg(2));
+                break;
+            case gate_kind::eq:
+                v[i] = ~(arg(0) ^ arg(1));
+                break;
+            }
+        }
+        values.insert(values.end(), v, v + num_sim_words);
+
+        gates.push_back({kind, std::move(args), std::move(name)});
+        const gate &g = gates.back();
+        if(g.kind != gate_kind::constant)
+            out << "def " << g.name << get_def(r) << "\n";
+        return r;
+    }
+
+    lit add(gate_kind kind, std::vector<lit> args) {
+        return add(kind, std::move(args), "g" + std::to_string(gates.size()));
+    }
+
+public:
+    circuit(std::ostream &out, std::mt19937_64 &rng)
+            : out(out), rng(rng) {
+        // The tester predefines the constants.
+        add(gate_kind::constant, {}, "0");
+    }
+
+    static lit get_false() { return 0; }
+    static lit get_true() { return 1; }
+
+    lit input(const std::string &name) {
+        return add(gate_kind::input, {}, name);
+    }
+
+    lit get_and(lit a, lit b) { return add(gate_kind::and_gate, {a, b}); }
+    lit get_or(lit a, lit b) { return add(gate_kind::or_gate, {a, b}); }
+    lit get_eq(lit a, lit b) { return add(gate_kind::eq, {a, b}); }
+    lit get_xor(lit a, lit b) { return get_eq(a, b) ^ 1; }
+
+    lit ifelse(lit i, lit t, lit e) {
+        return add(gate_kind::ifelse, {i, t, e});
+    }
+
+    std::string get_name(lit a) const {
+        if(a == get_true())
+            return "1";
+        return (a & 1 ? "~" : "") + gates[a / 2].name;
+    }
+
+    // The definition of the gate of the literal, as it follows
+    // the name in the tester's def command.
+    std::string get_def(lit a) const {
+        const gate &g = gates[a / 2];
+        if(g.kind == gate_kind::constant || g.kind == gate_kind::input)
+            return "";
+
+        std::string def = g.kind == gate_kind::and_gate ? " (and" :
+                          g.kind == gate_kind::or_gate ? " (or" :
+                          g.kind == gate_kind::ifelse ? " (ifelse" :
+                          " (eq";
+        for(lit arg : g.args)
+            def += " " + get_name(arg);
+        return def + ")";
+    }
+
+    // Whether the literals take different values on any of the
+    // simulated inputs.
+    bool differ(lit a, lit b) const {
+        std::uint64_t inv = (a ^ b) & 1 ? ~std::uint64_t(0) : 0;
+        for(unsigned i = 0; i != num_sim_words; ++i) {
+            if((get_values(a)[i] ^ get_values(b)[i] ^ inv) != 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+// Collects the assertions to write out once all the gates are
+// defined. The trivial ones come first, as they only hold before
+// the SAT checks start merging nodes.
+class assertion_set {
+private:
+    circuit &c;
+    std::mt19937_64 &rng;
+    const gen_options &opts;
+
+    std::vector<std::string> trivial_lines, sat_lines;
+    unsigned long counts[num_assertion_kinds] = {};
+
+public:
+    assertion_set(circuit &c, std::mt19937_64 &rng, const gen_options &opts)
+        : c(c), rng(rng), opts(opts) {}
+
+    // The first two literals are equal by construction. The third
+    // one is their faulty version, which is only asserted unequal
+    // if simulation tells it from the others.
+    void add(lit a, lit b, lit faulty) {
+        if(c.differ(a, b))
+            fatal("generated circuits are expected to be equal");
+
+        unsigned total = 0;
+        for(unsigned n : opts.mix)
+            total += n;
+        std::uint64_t r = rng() % total;
+        unsigned kind = 0;
+        while(r >= opts.mix[kind])
+            r -= opts.mix[kind++];
+
+        if(kind == unequal && !c.differ(a, faulty))
+            kind = equal;
+
+        ++counts[kind];
+        switch(kind) {
+        case trivially_equal: {
+            // Define the same gate once again.
+            std::string name = "t" + std::to_string(trivial_lines.size());
+            std::string def = c.get_def(a);
+            if(def.empty()) {
+                trivial_lines.push_back("assert_is " + c.get_name(a) + " " +
+                                        c.get_name(a));
+                break;
+            }
+            trivial_lines.push_back("def " + name + def);
+            trivial_lines.push_back("assert_is " + c.get_name(a & ~1u) + " " +
+                                    name);
+            break;
+        }
+        case equal:
+            sat_lines.push_back("assert_equiv " + c.get_name(a) + " " +
+                                c.get_name(b));
+            break;
+        case unequal:
+            sat_lines.push_back("assert_unequiv " + c.get_name(a) + " " +
+                                c.get_name(faulty));
+            break;
+        }
+    }
+
+    void write(std::ostream &out) const {
+        out << "\n";
+        for(const std::string &line : trivial_lines)
+            out << line << "\n";
+        out << "\n";
+        for(const std::string &line : sat_lines)
+            out << line << "\n";
+        out << "\n# " << counts[trivially_equal] << " trivially equal, " <<
+               counts[equal] << " equal, " << counts[unequal] <<
+               " unequal\n";
+    }
+};
+
+static word get_inputs(circuit &c, const std::string &name, unsigned width) {
+    word w;
+    for(unsigned i = 0; i != width; ++i)
+        w.push_back(c.input(name + std::to_string(i)));
+    return w;
+}
+
+static word add_ripple(circuit &c, const word &a, const word &b, lit carry) {
+    word sum;
+    for(std::size_t i = 0; i != a.size(); ++i) {
+        lit p = c.get_xor(a[i], b[i]);
+        sum.push_back(c.get_xor(p, carry));
+        lit g = c.get_and(a[i], b[i]);
+        carry = c.get_or(g, c.get_and(p, carry));
+    }
+    return sum;
+}
+
+// Kogge-Stone parallel prefix adder.
+static word add_lookahead(circuit &c, const word &a, const word &b,
+                          lit carry) {
+    std::size_t width = a.size();
+    word g, p;
+    for(std::size_t i = 0; i != width; ++i) {
+        g.push_back(c.get_and(a[i], b[i]));
+        p.push_back(c.get_xor(a[i], b[i]));
+    }
+
+    word pg = g, pp = p;
+    for(std::size_t d = 1; d < width; d *= 2) {
+        for(std::size_t i = width; i-- > d;) {
+            pg[i] = c.get_or(pg[i], c.get_and(pp[i], pg[i - d]));
+            pp[i] = c.get_and(pp[i], pp[i - d]);
+        }
+    }
+
+    word sum;
+    for(std::size_t i = 0; i != width; ++i) {
+        lit carry_i = i == 0 ? carry :
+                      c.get_or(pg[i - 1], c.get_and(pp[i - 1], carry));
+        sum.push_back(c.get_xor(p[i], carry_i));
+    }
+    return sum;
+}
+
+// Ripple-carry and lookahead adders; the faulty adder adds one.
+static void gen_adder(circuit &c, assertion_set &s, const gen_options &opts) {
+    word a = get_inputs(c, "a", opts.width);
+    word b = get_inputs(c, "b", opts.width);
+    word x = add_ripple(c, a, b, circuit::get_false());
+    word y = add_lookahead(c, a, b, circuit::get_false());
+    word z = add_ripple(c, a, b, circuit::get_true());
+    for(unsigned i = 0; i != opts.width; ++i)
+        s.add(x[i], y[i], z[i]);
+}
+
+// Returns the literals that are true for every value of the
+// selector, the least significant bit first.
+static word decode(circuit &c, const word &sel) {
+    word r = {circuit::get_true()};
+    for(lit s : sel) {
+        word next;
+        for(lit d : r)
+            next.push_back(c.get_and(d, s ^ 1));
+        for(lit d : r)
+            next.push_back(c.get_and(d, s));
+        r = next;
+    }
+    return r;
+}
+
+// Splits the selector in halves and combines their decoders.
+static word decode_split(circuit &c, const word &sel) {
+    if(sel.size() < 2)
+        return decode(c, sel);
+
+    std::size_t half = sel.size() / 2;
+    word lo = decode_split(c, word(sel.begin(), sel.begin() + half));
+    word hi = decode_split(c, word(sel.begin() + half, sel.end()));
+    word r;
+    for(lit h : hi) {
+        for(lit l : lo)
+            r.push_back(c.get_and(l, h));
+    }
+    return r;
+}
+
+static lit mux_tree(circuit &c, const word &sel, word data) {
+    for(lit s : sel) {
+        word next;
+        for(std::size_t i = 0; i + 1 < data.size(); i += 2)
+            next.push_back(c.ifelse(s, data[i + 1], data[i]));
+        data = next;
+    }
+    return data[0];
+}
+
+static lit mux_sop(circuit &c, const word &decoded, const word &data) {
+    lit r = circuit::get_false();
+    for(std::size_t i = 0; i != data.size(); ++i)
+        r = c.get_or(r, c.get_and(decoded[i], data[i]));
+    return r;
+}
+
+// Multiplexer trees and sum-of-products multiplexers, one per
+// rotation of the data inputs; the faulty trees have the first
+// two data inputs swapped.
+static void gen_mux(circuit &c, assertion_set &s, const gen_options &opts) {
+    unsigned num_sel = std::min(opts.width, 12u);
+    word sel = get_inputs(c, "s", num_sel);
+    word data = get_inputs(c, "d", 1u << num_sel);
+    word decoded = decode(c, sel);
+    for(unsigned r = 0; r != opts.width; ++r) {
+        word rotated = data;
+        std::rotate(rotated.begin(), rotated.begin() + r % data.size(),
+                    rotated.end());
+        word swapped = rotated;
+        std::swap(swapped[0], swapped[1]);
+        lit x = mux_tree(c, sel, rotated);
+        lit y = mux_sop(c, decoded, rotated);
+        lit z = mux_tree(c, sel, swapped);
+        s.add(x, y, z);
+    }
+}
+
+// Flat and split decoders; the faulty decoder has the outputs of
+// every pair swapped.
+static void gen_decoder(circuit &c, assertion_set &s,
+                        const gen_options &opts) {
+    word sel = get_inputs(c, "s", std::min(opts.width, 12u));
+    word x = decode(c, sel);
+    word y = decode_split(c, sel);
+    for(std::size_t i = 0; i != x.size(); ++i)
+        s.add(x[i], y[i], x[i ^ 1]);
+}
+
+enum class style { tree, sop };
+
+struct datapath {
+    style muxes;
+    bool lookahead;
+
+    // Swaps the AND and XOR operations.
+    bool faulty;
+
+    word regs[4];
+};
+
+static word select(circuit &c, style muxes, const word &sel,
+                   const word (&words)[4]) {
+    word r;
+    word decoded;
+    if(muxes == style::sop)
+        decoded = decode(c, sel);
+    for(std::size_t i = 0; i != words[0].size(); ++i) {
+        word bits = {words[0][i], words[1][i], words[2][i], words[3][i]};
+        r.push_back(muxes == style::tree ? mux_tree(c, sel, bits) :
+                                           mux_sop(c, decoded, bits));
+    }
+    return r;
+}
+
+// Executes an instruction with the specified fields.
+static void step(circuit &c, datapath &p, const word &op, const word &dst,
+                 const word &src1, const word &src2) {
+    word x = select(c, p.muxes, src1, p.regs);
+    word y = select(c, p.muxes, src2, p.regs);
+
+    word not_y, and_w, xor_w;
+    for(std::size_t i = 0; i != x.size(); ++i) {
+        not_y.push_back(y[i] ^ 1);
+        and_w.push_back(c.get_and(x[i], y[i]));
+        xor_w.push_back(c.get_xor(x[i], y[i]));
+    }
+
+    auto add = p.lookahead ? add_lookahead : add_ripple;
+    word results[4] = {
+        add(c, x, y, circuit::get_false()),
+        add(c, x, not_y, circuit::get_true()),
+        p.faulty ? xor_w : and_w,
+        p.faulty ? and_w : xor_w,
+    };
+    word result = select(c, p.muxes, op, results);
+
+    word writes = decode(c, dst);
+    for(unsigned r = 0; r != 4; ++r) {
+        word &reg = p.regs[r];
+        for(std::size_t i = 0; i != reg.size(); ++i) {
+            if(p.muxes == style::tree) {
+                reg[i] = c.ifelse(writes[r], result[i], reg[i]);
+                continue;
+            }
+            lit w = c.get_and(writes[r], result[i]);
+            reg[i] = c.get_or(w, c.get_and(writes[r] ^ 1, reg[i]));
+        }
+    }
+}
+
+// A datapath of four registers and an ALU doing addition,
+// subtraction, AND and XOR, executing symbolic instructions for the
+// specified number of cycles. One implementation uses multiplexer
+// trees and ripple-carry adders, the other one sum-of-products
+// multiplexers and lookahead adders.
+static void gen_cpu(circuit &c, assertion_set &s, const gen_options &opts) {
+    datapath paths[3] = {
+        {style::tree, false, false, {}},
+        {style::sop, true, false, {}},
+        {style::tree, false, true, {}},
+    };
+
+    for(unsigned r = 0; r != 4; ++r) {
+        word reg = get_inputs(c, "r" + std::to_string(r) + "_", opts.width);
+        for(datapath &p : paths)
+            p.regs[r] = reg;
+    }
+
+    for(unsigned n = 0; n != opts.cycles; ++n) {
+        std::string prefix = "i" + std::to_string(n) + "_";
+        word op = get_inputs(c, prefix + "op", 2);
+        word dst = get_inputs(c, prefix + "dst", 2);
+        word src1 = get_inputs(c, prefix + "src1_", 2);
+        word src2 = get_inputs(c, prefix + "src2_", 2);
+        for(datapath &p : paths)
+            step(c, p, op, dst, src1, src2);
+    }
+
+    for(unsigned r = 0; r != 4; ++r) {
+        for(unsigned i = 0; i != opts.width; ++i)
+            s.add(paths[0].regs[r][i], paths[1].regs[r][i],
+                  paths[2].regs[r][i]);
+    }
+}
+
+static unsigned parse_number(const char *arg) {
+    char *end;
+    unsigned long n = std::strtoul(arg, &end, 10);
+    if(*end != '\0')
+        fatal(std::string("number expected: ") + arg);
+    return static_cast<unsigned>(n);
+}
+
+}  // anonymous namespace
+
+int main(int argc, const char **argv) {
+    (void) argc;  // Unused.
+
+    gen_options opts;
+    std::string output_path;
+    std::string command = "gen";
+    int i = 1;
+    for(; argv[i]; ++i) {
+        std::string arg = argv[i];
+        if(arg[0] != '-')
+            break;
+        if(!argv[i + 1])
+            fatal("option '" + arg + "' expects a value");
+        if(arg == "--output") {
+            output_path = argv[++i];
+            continue;
+        }
+        command += " " + arg + " " + argv[i + 1];
+        if(arg == "--width") {
+            opts.width = parse_number(argv[++i]);
+            continue;
+        }
+        if(arg == "--cycles") {
+            opts.cycles = parse_number(argv[++i]);
+            continue;
+        }
+        if(arg == "--seed") {
+            opts.seed = parse_number(argv[++i]);
+            continue;
+        }
+        if(arg == "--mix") {
+            // Trivially equal, equal and unequal, e.g., 1,2,1.
+            std::istringstream s(argv[++i]);
+            std::string n;
+            unsigned k = 0;
+            while(std::getline(s, n, ',')) {
+                if(k == num_assertion_kinds)
+                    fatal("too many assertion frequencies");
+                opts.mix[k++] = parse_number(n.c_str());
+            }
+            if(k != num_assertion_kinds)
+                fatal("three assertion frequencies expected");
+            continue;
+        }
+        fatal("unknown option '" + arg + "'");
+    }
+
+    if(!argv[i] || argv[i + 1])
+        fatal("circuit expected: adder, mux, decoder or cpu");
+    std::string name = argv[i];
+    command += " " + name;
+
+    if(opts.width == 0)
+        fatal("the width has to be positive");
+    if(opts.mix[0] + opts.mix[1] + opts.mix[2] == 0)
+        fatal("at least one kind of assertions expected");
+
+    const struct {
+        const char *name;
+        void (*gen)(circuit &c, assertion_set &s, const gen_options &opts);
+    } circuits[] = {
+        {"adder", gen_adder},
+        {"mux", gen_mux},
+        {"decoder", gen_decoder},
+        {"cpu", gen_cpu},
+    };
+
+    for(const auto &circ : circuits) {
+        if(name != circ.name)
+            continue;
+
+        std::ofstream file;
+        if(!output_path.empty()) {
+            file.open(output_path);
+            if(!file)
+                fatal("cannot open " + output_path);
+        }
+        std::ostream &out = output_path.empty() ? std::cout : file;
+
+        out << "# Generated with: " << command << "\n\n";
+        std::mt19937_64 rng(opts.seed);
+        circuit c(out, rng);
+        assertion_set s(c, rng, opts);
+        circ.gen(c, s, opts);
+        s.write(out);
+        if(!out.flush())
+            fatal("cannot write the trace");
+        return EXIT_SUCCESS;
+    }
+
+    fatal("unknown circuit '" + name + "'");
+}
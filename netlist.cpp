@@ -0,0 +1,123 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#include <algorithm>
+
+#include "netlist.h"
+
+namespace eqbool {
+
+void netlist::schedule(gate_id g) {
+    gate &n = gates[g];
+    if(n.scheduled)
+        return;
+
+    n.scheduled = true;
+    if(queues.size() <= n.level)
+        queues.resize(n.level + 1);
+    queues[n.level].push_back(g);
+}
+
+eqbool netlist::compute(const gate &g) {
+    std::vector<eqbool> args;
+    for(gate_id a : g.args)
+        args.push_back(gates[a].value);
+
+    switch(g.kind) {
+    case gate_kind::input:
+        return g.value;
+    case gate_kind::not_gate:
+        return ~args[0];
+    case gate_kind::and_gate:
+        return context->get_and(args);
+    case gate_kind::or_gate:
+        return context->get_or(args);
+    case gate_kind::ifelse:
+        return context->ifelse(args[0], args[1], args[2]);
+    case gate_kind::eq:
+        return context->get_eq(args[0], args[1]);
+    }
+    unreachable("unknown gate kind");
+}
+
+netlist::gate_id netlist::add_input() {
+    gate_id id = gates.size();
+    gates.push_back(gate());
+    gate &n = gates.back();
+    n.kind = gate_kind::input;
+    n.value = context->get_false();
+    return id;
+}
+
+netlist::gate_id netlist::add_gate(gate_kind kind,
+                                   std::vector<gate_id> args) {
+    assert(kind != gate_kind::input);
+    assert(kind != gate_kind::not_gate || args.size() == 1);
+    assert(kind != gate_kind::ifelse || args.size() == 3);
+    assert(kind != gate_kind::eq || args.size() == 2);
+
+    gate_id id = gates.size();
+    gates.push_back(gate());
+    gate &n = gates.back();
+    n.kind = kind;
+    n.args = std::move(args);
+
+    for(gate_id a : n.args) {
+        assert(a < id);
+        gate &arg = gates[a];
+        n.level = std::max(n.level, arg.level + 1);
+        arg.fanouts.push_back(id);
+    }
+
+    // The value is computed on the next evaluation.
+    n.value = context->get_false();
+    schedule(id);
+    return id;
+}
+
+void netlist::set_input(gate_id input, eqbool value) {
+    gate &n = gates[input];
+    assert(n.kind == gate_kind::input);
+    assert(detail::are_compatible(value.get_context(), *context));
+    n.value = value;
+
+    // Inputs do not need to be recomputed, but their fan-outs do.
+    for(gate_id f : n.fanouts)
+        schedule(f);
+}
+
+void netlist::evaluate() {
+    ++stats.num_evaluations;
+
+    // Gates only depend on gates of lower levels, so every level
+    // only gets new gates scheduled until it is processed.
+    for(std::size_t level = 0; level < queues.size(); ++level) {
+        // Scheduling may grow the queues, so no references.
+        for(std::size_t i = 0; i != queues[level].size(); ++i) {
+            gate_id g = queues[level][i];
+            gate &n = gates[g];
+            n.scheduled = false;
+
+            ++stats.num_gate_evaluations;
+            eqbool v = compute(n);
+            eqbool old = n.value;
+            old.propagate();
+            n.value = v;
+            if(v == old)
+                continue;
+
+            for(gate_id f : n.fanouts)
+                schedule(f);
+        }
+        queues[level].clear();
+    }
+}
+
+}  // namespace eqbool
@@ -0,0 +1,102 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#ifndef EQBOOL_NETLIST_H
+#define EQBOOL_NETLIST_H
+
+#include <vector>
+
+#include "eqbool.h"
+
+namespace eqbool {
+
+enum class gate_kind { input, not_gate, and_gate, or_gate, ifelse, eq };
+
+struct netlist_stats {
+    unsigned long num_evaluations = 0;
+    unsigned long num_gate_evaluations = 0;
+};
+
+// Gates whose values are computed on every simulation cycle. Only
+// the gates in the fan-out of the inputs that changed since the
+// last evaluation are recomputed, in order of their levels, and
+// the propagation stops at gates whose values remain the same.
+class netlist {
+public:
+    using gate_id = std::size_t;
+
+private:
+    struct gate {
+        gate_kind kind;
+        std::vector<gate_id> args;
+        std::vector<gate_id> fanouts;
+        unsigned level = 0;
+        bool scheduled = false;
+        eqbool value;
+    };
+
+    eqbool_context *context;
+    std::vector<gate> gates;
+
+    // Scheduled gates by levels.
+    std::vector<std::vector<gate_id>> queues;
+
+    netlist_stats stats;
+
+    void schedule(gate_id g);
+    eqbool compute(const gate &g);
+
+public:
+    explicit netlist(eqbool_context &context)
+        : context(&context) {}
+
+    netlist(const netlist &) = delete;
+    netlist &operator = (const netlist &) = delete;
+
+    eqbool_context &get_context() const { return *context; }
+
+    // Continues in another context whose nodes can be mixed with
+    // those of the current one, e.g., an overlay of it once it is
+    // frozen.
+    void set_context(eqbool_context &c) {
+        assert(detail::are_compatible(c, *context));
+        context = &c;
+    }
+
+    std::size_t get_num_gates() const { return gates.size(); }
+    gate_kind get_kind(gate_id g) const { return gates[g].kind; }
+
+    // Inputs are false until set otherwise.
+    gate_id add_input();
+
+    // The arguments have to be added before the gate, so that
+    // netlists are always acyclic. State elements are to be
+    // modelled by the caller feeding the values of the gates back
+    // to the inputs for the next cycle.
+    gate_id add_gate(gate_kind kind, std::vector<gate_id> args);
+
+    void set_input(gate_id input, eqbool value);
+
+    // Brings the values of gates up to date.
+    void evaluate();
+
+    // Returns the value as of the last evaluation.
+    eqbool get_value(gate_id g) const {
+        eqbool v = gates[g].value;
+        v.propagate();
+        return v;
+    }
+
+    const netlist_stats &get_stats() const { return stats; }
+};
+
+}  // namespace eqbool
+
+#endif
@@ -0,0 +1,317 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "recorder.h"
+
+namespace eqbool {
+
+constexpr const char *call_recorder::magic;
+constexpr unsigned call_recorder::version;
+
+call_recorder::call_recorder(std::ostream &s)
+        : s(s) {
+    s.write(magic, static_cast<std::streamsize>(std::strlen(magic)));
+    write_number(version);
+
+    // The constants.
+    known.insert(0);
+}
+
+void call_recorder::write_number(std::uint64_t n) {
+    while(n >= 0x80) {
+        s.put(static_cast<char>((n & 0x7f) | 0x80));
+        n >>= 7;
+    }
+    s.put(static_cast<char>(n));
+}
+
+std::size_t call_recorder::get_term_number(uintptr_t term) {
+    auto r = terms.insert({term, terms.size()});
+    return r.first->second;
+}
+
+void call_recorder::define(eqbool e) {
+    e = e ^ e.is_inversion();
+    if(known.find(e.get_id() / 2) != known.end())
+        return;
+
+    // Collect the unknown nodes and define them in order of
+    // creation, so that arguments always come first.
+    std::vector<eqbool> unknown;
+    std::vector<eqbool> worklist({e});
+    while(!worklist.empty()) {
+        eqbool n = worklist.back();
+        worklist.pop_back();
+        n = n ^ n.is_inversion();
+        if(!known.insert(n.get_id() / 2).second)
+            continue;
+
+        unknown.push_back(n);
+        for(eqbool a : n.get_args())
+            worklist.push_back(a);
+    }
+
+    std::sort(unknown.begin(), unknown.end());
+
+    for(eqbool n : unknown) {
+        s.put(define_op);
+        write_node(n);
+        node_kind kind = n.get_kind();
+        write_number(static_cast<std::uint64_t>(kind));
+        if(kind == node_kind::term) {
+            write_number(get_term_number(n.get_term()));
+            continue;
+        }
+
+        args_ref args = n.get_args();
+        write_number(args.size());
+        for(eqbool a : args)
+            write_node(a);
+    }
+}
+
+void call_recorder::write_result(eqbool r) {
+    known.insert(r.get_id() / 2);
+    write_node(r);
+}
+
+void call_recorder::record_term(uintptr_t term, eqbool r) {
+    s.put(term_op);
+    write_number(get_term_number(term));
+    write_result(r);
+}
+
+void call_recorder::record_or(args_ref args, bool invert_args, eqbool r) {
+    for(eqbool a : args)
+        define(a);
+
+    s.put(or_op);
+    write_number(args.size());
+    for(eqbool a : args)
+        write_node(a);
+    write_number(invert_args);
+    write_result(r);
+}
+
+void call_recorder::record_ifelse(eqbool i, eqbool t, eqbool e, eqbool r) {
+    define(i);
+    define(t);
+    define(e);
+    s.put(ifelse_op);
+    write_node(i);
+    write_node(t);
+    write_node(e);
+    write_result(r);
+}
+
+void call_recorder::record_eq(eqbool a, eqbool b, eqbool r) {
+    define(a);
+    define(b);
+    s.put(eq_op);
+    write_node(a);
+    write_node(b);
+    write_result(r);
+}
+
+void call_recorder::record_equiv(eqbool a, eqbool b, bool r) {
+    define(a);
+    define(b);
+    s.put(equiv_op);
+    write_node(a);
+    write_node(b);
+    write_number(r);
+}
+
+bool call_player::read_number(std::uint64_t &n) {
+    n = 0;
+    for(unsigned shift = 0; shift < 64; shift += 7) {
+        int c = s->get();
+        if(c == std::istream::traits_type::eof())
+            return fail("unexpected end of trace");
+        n |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if(!(c & 0x80))
+            return true;
+    }
+    return fail("number is too large");
+}
+
+bool call_player::read_node(eqbool &e) {
+    std::uint64_t id;
+    if(!read_number(id))
+        return false;
+
+    if(id < 2) {
+        e = context.get(id == 1);
+        return true;
+    }
+
+    auto i = nodes.find(id / 2);
+    if(i == nodes.end())
+        return fail("undefined node " + std::to_string(id));
+    e = i->second ^ ((id & 1) != 0);
+    return true;
+}
+
+bool call_player::read_term(uintptr_t &term) {
+    std::uint64_t n;
+    if(!read_number(n))
+        return false;
+    if(n > terms.size())
+        return fail("terms are expected to be numbered in order");
+    term = terms.add("t" + std::to_string(n));
+    return true;
+}
+
+bool call_player::read_args(std::vector<eqbool> &args) {
+    std::uint64_t num_args;
+    if(!read_number(num_args))
+        return false;
+
+    args.clear();
+    for(std::uint64_t i = 0; i != num_args; ++i) {
+        eqbool a;
+        if(!read_node(a))
+            return false;
+        args.push_back(a);
+    }
+    return true;
+}
+
+void call_player::set_node(std::uint64_t id, eqbool e) {
+    nodes[id / 2] = e ^ ((id & 1) != 0);
+}
+
+bool call_player::define() {
+    std::uint64_t id, kind;
+    if(!read_number(id) || !read_number(kind))
+        return false;
+
+    eqbool e;
+    std::vector<eqbool> args;
+    switch(static_cast<node_kind>(kind)) {
+    case node_kind::term: {
+        uintptr_t term;
+        if(!read_term(term))
+            return false;
+        e = context.get(term);
+        break;
+    }
+    case node_kind::or_node:
+        if(!read_args(args))
+            return false;
+        e = context.get_or(args);
+        break;
+    case node_kind::ifelse:
+        if(!read_args(args))
+            return false;
+        if(args.size() != 3)
+            return fail("IFELSE nodes are expected to have three arguments");
+        e = context.ifelse(args[0], args[1], args[2]);
+        break;
+    case node_kind::eq:
+        if(!read_args(args))
+            return false;
+        if(args.size() != 2)
+            return fail("EQ nodes are expected to have two arguments");
+        e = context.get_eq(args[0], args[1]);
+        break;
+    default:
+        return fail("unknown node kind");
+    }
+
+    set_node(id, e);
+    return true;
+}
+
+bool call_player::play(std::istream &input, replay_stats &stats) {
+    s = &input;
+
+    std::size_t magic_size = std::strlen(call_recorder::magic);
+    std::string magic(magic_size, '\0');
+    if(!s->read(&magic[0], static_cast<std::streamsize>(magic_size)) ||
+           magic != call_recorder::magic)
+        return fail("not a trace");
+
+    std::uint64_t version;
+    if(!read_number(version))
+        return false;
+    if(version != call_recorder::version)
+        return fail("unsupported trace version");
+
+    timer t(stats.time);
+    for(;;) {
+        int op = s->get();
+        if(op == std::istream::traits_type::eof())
+            break;
+
+        if(op == call_recorder::define_op) {
+            if(!define())
+                return false;
+            ++stats.num_definitions;
+            continue;
+        }
+
+        ++stats.num_calls;
+        eqbool r;
+        std::vector<eqbool> args;
+        switch(op) {
+        case call_recorder::term_op: {
+            uintptr_t term;
+            if(!read_term(term))
+                return false;
+            r = context.get(term);
+            break;
+        }
+        case call_recorder::or_op: {
+            std::uint64_t invert_args;
+            if(!read_args(args) || !read_number(invert_args))
+                return false;
+            r = context.get_or(args, invert_args != 0);
+            break;
+        }
+        case call_recorder::ifelse_op:
+            args.resize(3);
+            if(!read_node(args[0]) || !read_node(args[1]) ||
+                   !read_node(args[2]))
+                return false;
+            r = context.ifelse(args[0], args[1], args[2]);
+            break;
+        case call_recorder::eq_op:
+            args.resize(2);
+            if(!read_node(args[0]) || !read_node(args[1]))
+                return false;
+            r = context.get_eq(args[0], args[1]);
+            break;
+        case call_recorder::equiv_op: {
+            eqbool a, b;
+            std::uint64_t recorded;
+            if(!read_node(a) || !read_node(b) || !read_number(recorded))
+                return false;
+            if(context.is_equiv(a, b) != (recorded != 0))
+                ++stats.num_mismatches;
+            continue;
+        }
+        default:
+            return fail("unknown opcode " + std::to_string(op));
+        }
+
+        std::uint64_t id;
+        if(!read_number(id))
+            return false;
+        set_node(id, r);
+    }
+
+    return true;
+}
+
+}  // namespace eqbool
@@ -0,0 +1,141 @@
+
+/*  Testing boolean expressions for equivalence.
+    https://github.com/kosarev/eqbool
+
+    Copyright (C) 2023-2025 Ivan Kosarev.
+    mail@ivankosarev.com
+
+    Published under the MIT license.
+*/
+
+#ifndef EQBOOL_RECORDER_H
+#define EQBOOL_RECORDER_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "eqbool.h"
+
+namespace eqbool {
+
+// Writes the calls made to a context to a stream, so they can be
+// reproduced without the application that made them. Nodes are
+// identified by their ids and terms by the order they first
+// appear in, so traces do not reveal anything but the structure
+// of the queries. Only the get(), get_or(), get_and(), ifelse(),
+// get_eq() and is_equiv() calls are recorded, including those made
+// by other methods of the context. Nodes the recorded calls do not
+// return, e.g., ones created before the recording started, are
+// recorded as definitions once they are used.
+//
+// Every record is an opcode byte followed by its operands, all
+// encoded as LEB128 numbers.
+class call_recorder {
+public:
+    enum opcode : unsigned char {
+        // ID KIND ARGS... for nodes not returned by recorded calls.
+        // KIND is the node kind. Terms have a term number instead of
+        // arguments and the other nodes have the number of
+        // arguments first.
+        define_op = 1,
+        term_op,      // TERM RESULT
+        or_op,        // NUM_ARGS ARGS... INVERT_ARGS RESULT
+        ifelse_op,    // I T E RESULT
+        eq_op,        // A B RESULT
+        equiv_op,     // A B RESULT
+    };
+
+    static constexpr const char *magic = "eqbtrace";
+    static constexpr unsigned version = 1;
+
+private:
+    std::ostream &s;
+
+    // Set while a recorded call is in progress, so that the calls
+    // it makes internally are not recorded.
+    bool busy = false;
+
+    // Ids of the non-inverted versions of the nodes the trace
+    // already refers to.
+    std::unordered_set<std::size_t> known;
+
+    std::unordered_map<uintptr_t, std::size_t> terms;
+
+    void write_number(std::uint64_t n);
+    std::size_t get_term_number(uintptr_t term);
+
+    // Writes definitions for the nodes in the cone of e that the
+    // trace doesn't refer to yet.
+    void define(eqbool e);
+
+    void write_node(eqbool e) { write_number(e.get_id()); }
+    void write_result(eqbool r);
+
+    void record_term(uintptr_t term, eqbool r);
+    void record_or(args_ref args, bool invert_args, eqbool r);
+    void record_ifelse(eqbool i, eqbool t, eqbool e, eqbool r);
+    void record_eq(eqbool a, eqbool b, eqbool r);
+    void record_equiv(eqbool a, eqbool b, bool r);
+
+    friend class eqbool_context;
+
+public:
+    // Writes the header.
+    explicit call_recorder(std::ostream &s);
+
+    call_recorder(const call_recorder &) = delete;
+    call_recorder &operator = (const call_recorder &) = delete;
+};
+
+struct replay_stats {
+    double time = 0;
+    unsigned long num_calls = 0;
+    unsigned long num_definitions = 0;
+
+    // is_equiv() calls that returned other than recorded.
+    unsigned long num_mismatches = 0;
+};
+
+// Performs the calls of recorded traces on a context. Terms are
+// added to the specified term table as t0, t1, etc.
+class call_player {
+private:
+    eqbool_context &context;
+    term_table &terms;
+
+    // Nodes of the context by the recorded ids of their
+    // non-inverted versions.
+    std::unordered_map<std::uint64_t, eqbool> nodes;
+
+    std::istream *s = nullptr;
+    std::string error;
+
+    bool fail(const std::string &msg) {
+        error = msg;
+        return false;
+    }
+
+    bool read_number(std::uint64_t &n);
+    bool read_node(eqbool &e);
+    bool read_term(uintptr_t &term);
+    bool read_args(std::vector<eqbool> &args);
+    void set_node(std::uint64_t id, eqbool e);
+    bool define();
+
+public:
+    call_player(eqbool_context &context, term_table &terms)
+        : context(context), terms(terms) {}
+
+    // Returns false if the trace is malformed, see get_error().
+    bool play(std::istream &s, replay_stats &stats);
+
+    const std::string &get_error() const { return error; }
+};
+
+}  // namespace eqbool
+
+#endif
@@ -30,7 +30,10 @@ eqbool_module = Extension(
                         ],
     sources=[
         'eqbool/_eqbool.cpp',
+        'bitvec.cpp',
         'eqbool.cpp',
+        'netlist.cpp',
+        'recorder.cpp',
         'cadical/src/analyze.cpp',
         'cadical/src/arena.cpp',
         'cadical/src/assume.cpp',
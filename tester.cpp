@@ -9,19 +9,37 @@
 */
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TESTER_MMAP 1
+#endif
+
 #include "eqbool.h"
+#include "netlist.h"
+#include "recorder.h"
 
 namespace {
 
 using eqbool::eqbool_context;
-using eqbool::term_set;
+using eqbool::term_table;
 using eqbool::eqbool;
 
 [[noreturn]] static void fatal(std::string msg) {
@@ -29,11 +47,214 @@ using eqbool::eqbool;
     std::exit(EXIT_FAILURE);
 }
 
+struct test_options {
+    bool find_mismatches = false;
+    unsigned long small_sat_threshold =
+        eqbool_context::default_small_sat_threshold;
+    std::vector<::eqbool::sat_profile> sat_profiles =
+        eqbool_context::get_default_sat_profiles();
+    std::size_t max_learned_implications =
+        eqbool_context::default_max_implications;
+    bool xor_reasoning = true;
+    ::eqbool::effort_level effort = ::eqbool::effort_level::normal;
+
+    // Where to record the calls made to the contexts, if anywhere.
+    std::string record_path;
+
+    bool latencies = false;
+
+    // Where to capture slow SAT queries, if anywhere.
+    std::string capture_dir;
+    double capture_min_time = 1;
+};
+
+using ::eqbool::latency_histogram;
+using ::eqbool::latency_stats;
+
+static const struct {
+    const char *name;
+    latency_histogram latency_stats::*histogram;
+} latency_ops[] = {
+    {"get", &latency_stats::get},
+    {"get_or", &latency_stats::get_or},
+    {"ifelse", &latency_stats::ifelse},
+    {"get_eq", &latency_stats::get_eq},
+    {"is_equiv", &latency_stats::is_equiv},
+};
+
+static std::string escape_json(const std::string &s) {
+    std::string r;
+    for(char c : s) {
+        if(c == '"' || c == '\\')
+            r += '\\';
+        r += c;
+    }
+    return r;
+}
+
+// The contents of an input file, mapped into memory where
+// supported.
+class input_file {
+private:
+    const char *data = nullptr;
+    std::size_t size = 0;
+    bool mapped = false;
+    std::string contents;
+
+public:
+    explicit input_file(const std::string &path) {
+#if TESTER_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            fatal("cannot open " + path);
+        struct stat st;
+        if(fstat(fd, &st) != 0)
+            fatal("cannot read " + path);
+        size = static_cast<std::size_t>(st.st_size);
+        if(size != 0) {
+            void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p == MAP_FAILED)
+                fatal("cannot map " + path);
+            data = static_cast<const char*>(p);
+            mapped = true;
+        }
+        close(fd);
+#else
+        std::ifstream f(path, std::ios::binary);
+        if(!f)
+            fatal("cannot open " + path);
+        std::ostringstream s;
+        if(f.peek() != std::ifstream::traits_type::eof() && !(s << f.rdbuf()))
+            fatal("cannot read " + path);
+        contents = s.str();
+        data = contents.data();
+        size = contents.size();
+#endif
+    }
+
+    ~input_file() {
+#if TESTER_MMAP
+        if(mapped)
+            munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    input_file(const input_file &) = delete;
+    input_file &operator = (const input_file &) = delete;
+
+    const char *get_data() const { return data; }
+    std::size_t get_size() const { return size; }
+};
+
+// A piece of input. Inputs are not copied, so tokens point into
+// them.
+class token {
+private:
+    const char *ptr = nullptr;
+    std::size_t len = 0;
+
+public:
+    token() = default;
+    token(const char *ptr, std::size_t len) : ptr(ptr), len(len) {}
+    token(const char *s) : token(s, std::strlen(s)) {}
+
+    const char *data() const { return ptr; }
+    std::size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    char back() const { return ptr[len - 1]; }
+
+    token drop_back() const { return token(ptr, len - 1); }
+
+    bool operator == (const char *s) const {
+        return std::strlen(s) == len &&
+               std::char_traits<char>::compare(ptr, s, len) == 0;
+    }
+
+    bool operator != (const char *s) const { return !(*this == s); }
+
+    std::string str() const { return std::string(ptr, len); }
+};
+
+// Reads a line of input.
+class line_reader {
+private:
+    const char *p;
+    const char *end;
+
+public:
+    static constexpr int eof = std::char_traits<char>::eof();
+
+    line_reader(const char *begin, const char *end)
+        : p(begin), end(end) {}
+
+    int peek() const {
+        return p == end ? eof : static_cast<unsigned char>(*p);
+    }
+
+    int get() {
+        return p == end ? eof : static_cast<unsigned char>(*p++);
+    }
+
+    void skip_spaces() {
+        while(p != end && std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+    }
+
+    bool at_end() {
+        skip_spaces();
+        return p == end;
+    }
+
+    // Reads a space-delimited word.
+    token read_word() {
+        skip_spaces();
+        const char *begin = p;
+        while(p != end && !std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        return token(begin, static_cast<std::size_t>(p - begin));
+    }
+
+    template<typename P>
+    token read_while(P pred) {
+        const char *begin = p;
+        while(p != end && pred(*p))
+            ++p;
+        return token(begin, static_cast<std::size_t>(p - begin));
+    }
+};
+
 class test_context {
 private:
-    term_set<std::string> terms;
-    eqbool_context eqbools{terms};
-    std::unordered_map<std::string, eqbool> nodes;
+    term_table terms;
+    eqbool_context base_eqbools{terms};
+
+    // Created when the base context gets frozen.
+    std::unique_ptr<eqbool_context> overlay_eqbools;
+
+    std::ofstream record_file;
+    std::unique_ptr<::eqbool::call_recorder> recorder;
+
+    eqbool_context &eqbools() {
+        return overlay_eqbools ? *overlay_eqbools : base_eqbools;
+    }
+
+    const eqbool_context &eqbools() const {
+        return overlay_eqbools ? *overlay_eqbools : base_eqbools;
+    }
+    // Nodes and gates by the numbers of their names, which are
+    // interned as they appear.
+    term_table node_names;
+    std::vector<eqbool> node_values;
+
+    // A context to import nodes to and back.
+    eqbool_context other{terms};
+    ::eqbool::import_map to_other, from_other;
+
+    ::eqbool::netlist net{base_eqbools};
+    using gate_id = ::eqbool::netlist::gate_id;
+    static constexpr gate_id no_gate = ~gate_id(0);
+    term_table gate_names;
+    std::vector<gate_id> gate_values;
 
     std::string filepath;
     unsigned line_no = 0;
@@ -42,6 +263,8 @@ private:
 
     bool find_mismatches = false;
 
+    std::ostream &out;
+
     [[noreturn]] void fatal(std::string msg) const {
         ::fatal(filepath + ": " + std::to_string(line_no) + ": " + msg);
     }
@@ -50,11 +273,32 @@ private:
         fatal(msg.str());
     }
 
-    eqbool get_node(std::string id) const {
-        auto it = nodes.find(id);
-        if(it == nodes.end())
-            fatal("undefined node '" + id + "'");
-        return it->second;
+    eqbool &get_node_slot(token id) {
+        uintptr_t n = node_names.add(id.data(), id.size());
+        if(n >= node_values.size())
+            node_values.resize(n + 1);
+        return node_values[n];
+    }
+
+    eqbool get_node(token id) {
+        eqbool e = get_node_slot(id);
+        if(!e)
+            fatal("undefined node '" + id.str() + "'");
+        return e;
+    }
+
+    gate_id &get_gate_slot(token id) {
+        uintptr_t n = gate_names.add(id.data(), id.size());
+        if(n >= gate_values.size())
+            gate_values.resize(n + 1, no_gate);
+        return gate_values[n];
+    }
+
+    gate_id get_gate(token id) {
+        gate_id g = get_gate_slot(id);
+        if(g == no_gate)
+            fatal("undefined gate '" + id.str() + "'");
+        return g;
     }
 
     void check_num_args(const std::vector<eqbool> &args, unsigned n) const {
@@ -69,18 +313,25 @@ private:
                c == '_';
     }
 
-    eqbool parse_expr(std::istream &s) {
-        s >> std::ws;
+    // Queries that got to the SAT stage, including those refuted
+    // before calling a solver.
+    unsigned long get_num_sat_queries() {
+        const ::eqbool::eqbool_stats &stats = eqbools().get_stats();
+        return stats.num_sat_solutions + stats.num_xor_refutations;
+    }
+
+    eqbool parse_expr(line_reader &s) {
+        s.skip_spaces();
         int c = s.peek();
         if(c == '(') {
             s.get();
-            std::string op;
-            if(!(s >> op))
+            token op = s.read_word();
+            if(op.empty())
                 fatal("operator expected");
 
             std::vector<eqbool> args;
             if(op.back() == ')') {
-                op.resize(op.size() - 1);
+                op = op.drop_back();
             } else {
                 for(;;) {
                     eqbool a = parse_expr(s);
@@ -97,29 +348,47 @@ private:
                 return ~args[0];
             }
             if(op == "and")
-                return eqbools.get_and(args);
+                return eqbools().get_and(args);
             if(op == "or")
-                return eqbools.get_or(args);
+                return eqbools().get_or(args);
             if(op == "ifelse") {
                 check_num_args(args, 3);
-                return eqbools.ifelse(args[0], args[1], args[2]);
+                return eqbools().ifelse(args[0], args[1], args[2]);
             }
             if(op == "eq") {
                 check_num_args(args, 2);
-                return eqbools.get_eq(args[0], args[1]);
+                return eqbools().get_eq(args[0], args[1]);
+            }
+            if(op == "import") {
+                // Round trip via another context.
+                check_num_args(args, 1);
+                eqbool e = other.import(eqbools(), args[0], to_other);
+                return eqbools().import(other, e, from_other);
+            }
+            if(op == "subst") {
+                // (subst E TERM VALUE...)
+                if(args.size() % 2 != 1)
+                    fatal("term and value pairs expected");
+                ::eqbool::substitution subst;
+                for(std::size_t i = 1; i != args.size(); i += 2) {
+                    if(args[i].is_inversion() ||
+                           args[i].get_kind() != ::eqbool::node_kind::term)
+                        fatal("term expected");
+                    subst.set(args[i].get_term(), args[i + 1]);
+                }
+                return eqbools().substitute(args[0], subst);
             }
 
             fatal("unknown operator");
         }
 
-        if(is_id_char(c)) {
-            std::string id;
-            while(is_id_char(c)) {
-                id.push_back(static_cast<char>(c));
-                s.get();
-                c = s.peek();
-            }
-            return get_node(id);
+        if(is_id_char(c))
+            return get_node(s.read_while(is_id_char));
+
+        // The value of a netlist gate.
+        if(c == '@') {
+            s.get();
+            return net.get_value(get_gate(s.read_while(is_id_char)));
         }
 
         if(c == '~') {
@@ -133,43 +402,43 @@ private:
         return {};
     }
 
-    void process_test_line(const std::string &line) {
-        std::istringstream s(line);
-        std::string op;
-        if(!(s >> op))
+    void process_test_line(line_reader s) {
+        token op = s.read_word();
+        if(op.empty())
             fatal("operator expected");
 
         if(op == "def") {
-            std::string r;
-            if(!(s >> r))
+            token r = s.read_word();
+            if(r.empty())
                 fatal("result node expected");
             eqbool e = parse_expr(s);
             if(!e)
-                e = eqbools.get(terms.add(r));
-            if(s.peek() != std::istream::traits_type::eof())
+                e = eqbools().get(terms.add(r.data(), r.size()));
+            if(!s.at_end())
                 fatal("unexpected arguments");
-            eqbool &n = nodes[r];
+            eqbool &n = get_node_slot(r);
             if(n)
                 fatal("result is already defined");
             n = e;
             return;
         }
 
-        if(op == "assert_is" ||
+        if(op == "assert_is" || op == "assert_is_not" ||
                op == "assert_equiv" || op == "assert_unequiv" ||
-               op == "assert_sat_equiv" || op == "assert_sat_unequiv") {
+               op == "assert_sat_equiv" || op == "assert_sat_unequiv" ||
+               op == "assert_implies" || op == "assert_not_implies") {
             eqbool a = parse_expr(s);
             eqbool b = parse_expr(s);
             if(!a || !b)
                 fatal("arguments expected");
-            if(s.peek() != std::istream::traits_type::eof())
+            if(!s.at_end())
                 fatal("unexpected arguments");
             if(op == "assert_is") {
-                if(!eqbools.is_trivially_equiv(a, b)) {
+                if(!eqbools().is_trivially_equiv(a, b)) {
                     if(find_mismatches) {
                         std::ostringstream ss;
                         ss << "(" << a << ") vs (" << b << ")";
-                        std::cout << line_no << ": " << ss.str().size() <<
+                        out << line_no << ": " << ss.str().size() <<
                                      " " << ss.str() << "\n";
                     } else {
                         fatal(std::ostringstream() <<
@@ -178,22 +447,196 @@ private:
                                   "b: " << b);
                     }
                 }
+            } else if(op == "assert_is_not") {
+                if(eqbools().is_trivially_equiv(a, b)) {
+                    fatal(std::ostringstream() <<
+                              "nodes match\n"
+                              "a: " << a << "\n"
+                              "b: " << b);
+                }
+            } else if(op == "assert_implies" || op == "assert_not_implies") {
+                bool res = (op == "assert_implies");
+                if(eqbools().implies(a, b) != res) {
+                    fatal(std::ostringstream() <<
+                        "implication check failed\n" <<
+                        "a: " << a << "\n"
+                        "b: " << b);
+                }
             } else {
                 bool res = (op == "assert_equiv" || op == "assert_sat_equiv");
                 bool sat = (op == "assert_sat_equiv" || op == "assert_sat_unequiv");
-                unsigned long count = eqbools.get_stats().num_sat_solutions;
-                if(eqbools.is_equiv(a, b) != res) {
+                unsigned long count = get_num_sat_queries();
+                if(eqbools().is_equiv(a, b) != res) {
                     fatal(std::ostringstream() <<
                         "equivalence check failed\n" <<
                         "a: " << a << "\n"
                         "b: " << b);
                 }
-                if(sat && eqbools.get_stats().num_sat_solutions == count)
+                if(sat && get_num_sat_queries() == count)
                     fatal("equivlance check resolved without using SAT solver");
             }
             return;
         }
 
+        // Results are checked as they arrive.
+        if(op == "async_equiv" || op == "async_unequiv") {
+            eqbool a = parse_expr(s);
+            eqbool b = parse_expr(s);
+            if(!a || !b)
+                fatal("arguments expected");
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            bool res = (op == "async_equiv");
+            std::string path = filepath;
+            unsigned submitted = line_no;
+            eqbools().is_equiv_async(a, b, [=](bool equiv) {
+                if(equiv != res) {
+                    ::fatal(path + ": " + std::to_string(submitted) + ": " +
+                            "asynchronous equivalence check failed");
+                }
+            });
+            return;
+        }
+
+        if(op == "future_equiv" || op == "future_unequiv") {
+            eqbool a = parse_expr(s);
+            eqbool b = parse_expr(s);
+            if(!a || !b)
+                fatal("arguments expected");
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            bool res = (op == "future_equiv");
+            if(eqbools().is_equiv_async(a, b).get() != res)
+                fatal("asynchronous equivalence check failed");
+            return;
+        }
+
+        if(op == "sync") {
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            eqbools().sync();
+            return;
+        }
+
+        // gate NAME [KIND ARG...]
+        if(op == "gate") {
+            token r = s.read_word();
+            if(r.empty())
+                fatal("gate name expected");
+            gate_id &g = get_gate_slot(r);
+            if(g != no_gate)
+                fatal("gate is already defined");
+            token kind = s.read_word();
+            if(kind.empty()) {
+                g = net.add_input();
+                return;
+            }
+
+            std::vector<gate_id> args;
+            for(token arg = s.read_word(); !arg.empty(); arg = s.read_word())
+                args.push_back(get_gate(arg));
+
+            using ::eqbool::gate_kind;
+            gate_kind k;
+            std::size_t num_args = args.size();
+            if(kind == "not") {
+                k = gate_kind::not_gate;
+            } else if(kind == "and") {
+                k = gate_kind::and_gate;
+            } else if(kind == "or") {
+                k = gate_kind::or_gate;
+            } else if(kind == "ifelse") {
+                k = gate_kind::ifelse;
+                num_args = 3;
+            } else if(kind == "eq") {
+                k = gate_kind::eq;
+                num_args = 2;
+            } else {
+                fatal("unknown gate kind");
+            }
+            if(k == gate_kind::not_gate)
+                num_args = 1;
+            if(args.size() != num_args)
+                fatal(std::to_string(num_args) + " arguments expected");
+
+            // Adding gates does not invalidate the slot.
+            g = net.add_gate(k, args);
+            return;
+        }
+
+        if(op == "set") {
+            token r = s.read_word();
+            if(r.empty())
+                fatal("gate name expected");
+            eqbool e = parse_expr(s);
+            if(!e)
+                fatal("value expected");
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            gate_id g = get_gate(r);
+            if(net.get_kind(g) != ::eqbool::gate_kind::input)
+                fatal("input gate expected");
+            net.set_input(g, e);
+            return;
+        }
+
+        if(op == "eval") {
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            net.evaluate();
+            return;
+        }
+
+        // Continues in an overlay of the context built so far.
+        if(op == "freeze") {
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            if(overlay_eqbools)
+                fatal("already frozen");
+            base_eqbools.freeze();
+            overlay_eqbools.reset(new eqbool_context(&base_eqbools));
+            overlay_eqbools->set_recorder(recorder.get());
+            net.set_context(*overlay_eqbools);
+            return;
+        }
+
+        if(op == "compact") {
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            if(net.get_num_gates() != 0)
+                fatal("cannot compact nodes of netlist gates");
+            if(recorder)
+                fatal("cannot compact while recording");
+            eqbools().compact(node_values);
+            to_other.clear();
+            from_other.clear();
+            return;
+        }
+
+        // sweep [BUDGET [complete|incomplete]]
+        if(op == "sweep") {
+            unsigned long budget = ~0ul;
+            token arg = s.read_word();
+            if(!arg.empty()) {
+                std::string n = arg.str();
+                char *end;
+                budget = std::strtoul(n.c_str(), &end, 10);
+                if(*end != '\0')
+                    fatal("sweep budget expected");
+            }
+            token expected = s.read_word();
+            if(!expected.empty() && expected != "complete" &&
+                   expected != "incomplete")
+                fatal("'complete' or 'incomplete' expected");
+            if(!s.at_end())
+                fatal("unexpected arguments");
+            ::eqbool::sweep_result r = eqbools().sweep(budget);
+            if(!expected.empty() && r.complete != (expected == "complete"))
+                fatal(r.complete ? "sweep is complete" :
+                                   "sweep is incomplete");
+            return;
+        }
+
         fatal("unknown command");
     }
 
@@ -208,21 +651,140 @@ private:
     }
 
     void print_stats(std::ostream &s) const {
-        const ::eqbool::eqbool_stats &stats = eqbools.get_stats();
+        const ::eqbool::eqbool_stats &stats = eqbools().get_stats();
         double other_time = total_time - (stats.sat_time + stats.clauses_time);
         s <<
              line_no << ": " <<
              format(static_cast<long>(total_time * 1000)) << " ms, " <<
-             format(stats.num_sat_solutions) << " solutions " <<
+             format(stats.num_sat_solutions) << " solutions (" <<
+             format(stats.num_small_sat_solutions) << " small) " <<
              format(static_cast<long>(stats.sat_time * 1000)) << " ms, " <<
              format(stats.num_clauses) << " clauses " <<
              format(static_cast<long>(stats.clauses_time * 1000)) << " ms, " <<
              "other " << format(static_cast<long>(other_time * 1000)) << " ms\n";
+
+        using ::eqbool::node_kind;
+        ::eqbool::memory_stats ms = eqbools().get_memory_stats();
+        s << "  memory: " <<
+             format(ms.total_bytes / 1024) << " KiB, " <<
+             format(ms.get_num_nodes(node_kind::term)) << " terms " <<
+             format(ms.get_num_nodes(node_kind::or_node)) << " or " <<
+             format(ms.get_num_nodes(node_kind::ifelse)) << " ifelse " <<
+             format(ms.get_num_nodes(node_kind::eq)) << " eq nodes " <<
+             format(ms.node_bytes / 1024) << " KiB, " <<
+             format(ms.num_args) << " args " <<
+             format(ms.arg_bytes / 1024) << " KiB, " <<
+             format(ms.num_buckets) << " buckets " <<
+             format(static_cast<long>(ms.load_factor * 100)) << "% full " <<
+             format(ms.bucket_bytes / 1024) << " KiB\n";
+
+        const auto &profiles = eqbools().get_sat_profiles();
+        for(std::size_t i = 0; i != profiles.size(); ++i) {
+            const ::eqbool::sat_profile_stats &ps = stats.sat_profiles[i];
+            if(ps.num_sat_solutions == 0)
+                continue;
+            s << "  " << profiles[i].name << ": " <<
+                 format(ps.num_sat_solutions) << " solutions (" <<
+                 format(ps.num_unsat) << " unsat) " <<
+                 format(static_cast<long>(ps.sat_time * 1000)) << " ms\n";
+        }
+
+        if(stats.num_learned_implications != 0) {
+            s << "  implications: " <<
+                 format(stats.num_learned_implications) << " learned, " <<
+                 format(stats.num_implication_hits) << " hits\n";
+        }
+
+        if(stats.num_xor_refutations != 0 || stats.num_xor_clauses != 0) {
+            s << "  xor: " <<
+                 format(stats.num_xor_refutations) << " refutations, " <<
+                 format(stats.num_xor_clauses) << " clauses " <<
+                 format(static_cast<long>(stats.xor_time * 1000)) << " ms\n";
+        }
+
+        const ::eqbool::netlist_stats &net_stats = net.get_stats();
+        if(net_stats.num_evaluations != 0) {
+            s << "  netlist: " <<
+                 format(net_stats.num_evaluations) << " evaluations, " <<
+                 format(net_stats.num_gate_evaluations) <<
+                 " gate evaluations\n";
+        }
+
+        if(stats.num_async_sat_solutions != 0) {
+            s << "  async: " <<
+                 format(stats.num_async_sat_solutions) << " solutions\n";
+        }
+
+        if(stats.num_captured_queries != 0) {
+            s << "  capture: " <<
+                 format(stats.num_captured_queries) << " queries\n";
+        }
+
+        if(stats.num_swept_merges != 0) {
+            s << "  sweep: " <<
+                 format(stats.num_swept_merges) << " merges " <<
+                 format(static_cast<long>(stats.sweep_time * 1000)) << " ms\n";
+        }
+
+        latency_stats latencies = get_latencies();
+        for(const auto &op : latency_ops) {
+            const latency_histogram &h = latencies.*op.histogram;
+            if(h.get_count() == 0)
+                continue;
+            s << "  latency " << op.name << ": " <<
+                 format(h.get_count()) << " calls, " <<
+                 "p50 " << format(h.get_percentile(50)) << " ns, " <<
+                 "p90 " << format(h.get_percentile(90)) << " ns, " <<
+                 "p99 " << format(h.get_percentile(99)) << " ns, " <<
+                 "max " << format(h.get_max()) << " ns\n";
+        }
+
+        const ::eqbool::eqbool_stats::hot_path_stats &hot = stats.hot;
+        if(hot.num_lookups != 0) {
+            s << "  lookups: " <<
+                 format(hot.num_lookups) << " lookups, " <<
+                 format(hot.num_lookup_probes) << " probes, " <<
+                 format(hot.num_lookup_hits) << " hits, " <<
+                 format(hot.num_base_lookup_hits) << " base hits, " <<
+                 format(hot.num_inserts) << " inserts\n";
+            s << "  build: " <<
+                 format(static_cast<long>(hot.build_time * 1000)) << " ms, " <<
+                 "reduce " <<
+                 format(hot.num_reductions) << " calls " <<
+                 format(hot.num_reduction_rounds) << " rounds " <<
+                 format(static_cast<long>(hot.reduce_time * 1000)) << " ms, " <<
+                 "evaluate " <<
+                 format(hot.num_evaluations) << " calls " <<
+                 format(hot.num_evaluation_rounds) << " rounds " <<
+                 format(static_cast<long>(hot.evaluate_time * 1000)) <<
+                 " ms\n";
+            s << "  propagate: " <<
+                 format(hot.num_propagations) << " chains, " <<
+                 format(hot.num_propagation_steps) << " steps\n";
+            s << "  rules: " <<
+                 format(hot.num_constant_folds) << " constant folds, " <<
+                 format(hot.num_subsumptions) << " subsumptions, " <<
+                 format(hot.num_ifelse_recognitions) << " ifelse, " <<
+                 format(hot.num_eq_cancellations) << " eq cancellations\n";
+        }
+    }
+
+    // Includes the latencies of the base context, if frozen.
+    latency_stats get_latencies() const {
+        latency_stats latencies = base_eqbools.get_stats().latencies;
+        if(overlay_eqbools) {
+            const latency_stats &overlay_latencies =
+                overlay_eqbools->get_stats().latencies;
+            for(const auto &op : latency_ops)
+                (latencies.*op.histogram).merge(
+                    overlay_latencies.*op.histogram);
+        }
+        return latencies;
     }
 
     void print_stats() {
-        print_stats(find_mismatches ? std::cerr : std::cout);
-        std::cout.flush();
+        print_stats(find_mismatches ? std::cerr : out);
+        out.flush();
 
         std::ostringstream s;
         print_stats(s);
@@ -235,23 +797,50 @@ public:
     total_times_type &total_times;
 
     test_context(std::string filepath, total_times_type &total_times,
-                 bool find_mismatches)
-            : filepath(filepath), find_mismatches(find_mismatches),
-              total_times(total_times) {
-        nodes["0"] = eqbools.get_false();
-        nodes["1"] = eqbools.get_true();
+                 const test_options &opts, std::ostream &out = std::cout)
+            : filepath(filepath), find_mismatches(opts.find_mismatches),
+              out(out), total_times(total_times) {
+        eqbools().set_small_sat_threshold(opts.small_sat_threshold);
+        eqbools().set_sat_profiles(opts.sat_profiles);
+        eqbools().set_max_learned_implications(opts.max_learned_implications);
+        eqbools().set_xor_reasoning(opts.xor_reasoning);
+        eqbools().set_effort(opts.effort);
+        get_node_slot("0") = eqbools().get_false();
+        get_node_slot("1") = eqbools().get_true();
+
+        if(!opts.record_path.empty()) {
+            record_file.open(opts.record_path, std::ios::binary);
+            if(!record_file)
+                ::fatal("cannot open " + opts.record_path);
+            recorder.reset(new ::eqbool::call_recorder(record_file));
+            base_eqbools.set_recorder(recorder.get());
+        }
+
+        base_eqbools.set_latency_recording(opts.latencies);
+        base_eqbools.set_query_capture(opts.capture_dir,
+                                       opts.capture_min_time);
+    }
+
+    ~test_context() {
+        base_eqbools.set_recorder(nullptr);
+        if(overlay_eqbools)
+            overlay_eqbools->set_recorder(nullptr);
     }
 
-    void process_test_lines(std::istream &f) {
+    void process_test_lines(const char *data, std::size_t size) {
         ::eqbool::timer t(total_time);
 
-        std::string line;
+        const char *p = data;
+        const char *end = data + size;
         unsigned last_reported_line_no = 0;
-        while(std::getline(f, line)) {
+        while(p != end) {
+            const char *eol = static_cast<const char*>(
+                std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            const char *line_end = eol ? eol : end;
             ++line_no;
-            // std::cout << std::to_string(line_no) << ": " << line << "\n";
-            if(!line.empty() && line[0] != '#')
-                process_test_line(line);
+            if(line_end != p && *p != '#')
+                process_test_line(line_reader(p, line_end));
+            p = eol ? eol + 1 : end;
             if(line_no % 100000 == 0) {
                 t.update();
                 print_stats();
@@ -259,69 +848,640 @@ public:
             }
         }
 
+        eqbools().sync();
+
         if(line_no != last_reported_line_no) {
             t.update();
             print_stats();
         }
 
-        if(!f.eof())
-            fatal("cannot read input");
+        if(recorder && !record_file.flush())
+            ::fatal("cannot write the recorded calls");
+    }
+
+    double get_total_time() const { return total_time; }
+
+    const ::eqbool::eqbool_stats &get_stats() const {
+        return eqbools().get_stats();
+    }
+
+    ::eqbool::memory_stats get_memory_stats() const {
+        return eqbools().get_memory_stats();
+    }
+
+    void print_latencies_json(std::ostream &s) const {
+        latency_stats latencies = get_latencies();
+        const char *sep = "{";
+        for(const auto &op : latency_ops) {
+            const latency_histogram &h = latencies.*op.histogram;
+            s << sep << "\"" << op.name << "\": {" <<
+                 "\"count\": " << h.get_count() << ", " <<
+                 "\"p50\": " << h.get_percentile(50) << ", " <<
+                 "\"p90\": " << h.get_percentile(90) << ", " <<
+                 "\"p99\": " << h.get_percentile(99) << ", " <<
+                 "\"max\": " << h.get_max() << "}";
+            sep = ", ";
+        }
+        s << "}";
+    }
+};
+
+constexpr test_context::gate_id test_context::no_gate;
+
+// NAME[,config=CONFIG][,max-clauses=N][,min-unsat-ratio=R][,OPTION=N...]
+static ::eqbool::sat_profile parse_sat_profile(const std::string &arg) {
+    ::eqbool::sat_profile profile;
+    std::istringstream s(arg);
+    std::getline(s, profile.name, ',');
+    std::string field;
+    while(std::getline(s, field, ',')) {
+        std::size_t eq = field.find('=');
+        if(eq == std::string::npos)
+            fatal("malformed SAT profile field '" + field + "'");
+        std::string key = field.substr(0, eq);
+        std::string value = field.substr(eq + 1);
+        if(key == "config") {
+            profile.config = value;
+            continue;
+        }
+
+        char *end;
+        if(key == "max-clauses")
+            profile.max_clauses = std::strtoul(value.c_str(), &end, 10);
+        else if(key == "min-unsat-ratio")
+            profile.min_unsat_ratio = std::strtod(value.c_str(), &end);
+        else
+            profile.options.push_back(
+                {key, static_cast<int>(std::strtol(value.c_str(), &end,
+                                                   10))});
+        if(value.empty() || *end != '\0')
+            fatal("malformed SAT profile field '" + field + "'");
+    }
+    if(!eqbool_context::is_valid_sat_profile(profile))
+        fatal("invalid SAT profile '" + arg + "'");
+    return profile;
+}
+
+static ::eqbool::effort_level parse_effort(const std::string &name) {
+    if(name == "fast")
+        return ::eqbool::effort_level::fast;
+    if(name == "normal")
+        return ::eqbool::effort_level::normal;
+    if(name == "strong")
+        return ::eqbool::effort_level::strong;
+    fatal("unknown effort level '" + name + "'");
+}
+
+// Replays the calls of a trace written with --record.
+static void replay(const std::string &path, const test_options &opts) {
+    std::ifstream f(path, std::ios::binary);
+    if(!f)
+        fatal("cannot open " + path);
+
+    term_table terms;
+    eqbool_context eqbools(terms);
+    eqbools.set_small_sat_threshold(opts.small_sat_threshold);
+    eqbools.set_sat_profiles(opts.sat_profiles);
+    eqbools.set_max_learned_implications(opts.max_learned_implications);
+    eqbools.set_xor_reasoning(opts.xor_reasoning);
+    eqbools.set_effort(opts.effort);
+
+    ::eqbool::call_player player(eqbools, terms);
+    ::eqbool::replay_stats stats;
+    if(!player.play(f, stats))
+        fatal(path + ": " + player.get_error());
+
+    const ::eqbool::eqbool_stats &eqbool_stats = eqbools.get_stats();
+    std::cout << path << ": " <<
+                 static_cast<long>(stats.time * 1000) << " ms, " <<
+                 stats.num_calls << " calls, " <<
+                 stats.num_definitions << " definitions, " <<
+                 eqbool_stats.num_sat_solutions << " solutions " <<
+                 static_cast<long>(eqbool_stats.sat_time * 1000) << " ms\n";
+
+    if(stats.num_mismatches != 0)
+        fatal(path + ": " + std::to_string(stats.num_mismatches) +
+              " equivalence checks differ from the recorded ones");
+}
+
+// Solves captured queries with each of the profiles.
+static void solve_dimacs(const std::string &path,
+                         const std::vector<::eqbool::sat_profile> &profiles) {
+    std::ifstream f(path);
+    if(!f)
+        fatal("cannot open " + path);
+
+    ::eqbool::cnf clauses;
+    if(!clauses.read_dimacs(f))
+        fatal(path + ": malformed DIMACS input");
+
+    for(const ::eqbool::sat_profile &profile : profiles) {
+        double time = 0;
+        bool unsat;
+        {
+            ::eqbool::timer t(time);
+            unsat = eqbool_context::is_unsat(clauses, profile);
+        }
+
+        std::cout << path << ": " << profile.name << ": " <<
+                     (unsat ? "unsat " : "sat ") <<
+                     static_cast<long>(time * 1000) << " ms, " <<
+                     clauses.num_vars << " vars, " <<
+                     clauses.num_clauses << " clauses\n";
+    }
+}
+
+// Solves the queries captured to a directory, in order.
+static void solve_captured(const std::string &dir,
+                           const std::vector<::eqbool::sat_profile> &profiles) {
+    unsigned long n = 0;
+    for(;; ++n) {
+        std::string path = eqbool_context::get_capture_path(dir, n);
+        if(!std::ifstream(path))
+            break;
+        solve_dimacs(path, profiles);
     }
+    if(n == 0)
+        fatal("no captured queries in " + dir);
+}
+
+struct run_options {
+    test_options test;
+    std::string effort;
+    int num_runs = 1;
+    bool test_performance = false;
+    bool latency_json = false;
 };
 
+struct input_result {
+    test_context::total_times_type total_times;
+    std::string latency_json;
+
+    // Of every run.
+    std::vector<double> times;
+
+    // Of the last run.
+    double time = 0;
+    unsigned long num_sat_solutions = 0;
+    unsigned long num_clauses = 0;
+    std::size_t num_nodes = 0;
+};
+
+static void run_input(const std::string &path, const run_options &opts,
+                      std::ostream &out, input_result &result) {
+    input_file input(path);
+    for(int n = 0; n != opts.num_runs; ++n) {
+        if(opts.test_performance) {
+            if(n != 0)
+                out << "\n";
+            out << "run #" << n + 1 << "\n";
+        }
+
+        test_context c(path, result.total_times, opts.test, out);
+        c.process_test_lines(input.get_data(), input.get_size());
+        result.times.push_back(c.get_total_time());
+
+        if(n != opts.num_runs - 1)
+            continue;
+
+        result.time = c.get_total_time();
+        result.num_sat_solutions = c.get_stats().num_sat_solutions;
+        result.num_clauses = c.get_stats().num_clauses;
+
+        ::eqbool::memory_stats ms = c.get_memory_stats();
+        for(std::size_t num : ms.num_nodes)
+            result.num_nodes += num;
+
+        if(opts.latency_json) {
+            std::ostringstream json;
+            json << "{\"file\": \"" << escape_json(path) << "\", " <<
+                    "\"effort\": \"" << opts.effort << "\", " <<
+                    "\"latencies\": ";
+            c.print_latencies_json(json);
+            json << "}";
+            result.latency_json = json.str();
+        }
+    }
+}
+
+// Runs the inputs on the specified number of threads. Prints the
+// output of every input as a whole, in order of the inputs, and
+// then a summary.
+static void run_inputs_in_parallel(const std::vector<std::string> &paths,
+                                   const run_options &opts,
+                                   unsigned num_jobs,
+                                   std::vector<input_result> &results) {
+    std::vector<std::ostringstream> outputs(paths.size());
+    results.resize(paths.size());
+
+    double wall_time = 0;
+    {
+        ::eqbool::timer t(wall_time);
+        std::atomic<std::size_t> next{0};
+        auto work = [&]() {
+            for(;;) {
+                std::size_t k = next++;
+                if(k >= paths.size())
+                    break;
+                run_input(paths[k], opts, outputs[k], results[k]);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(unsigned n = 0; n != num_jobs && n != paths.size(); ++n)
+            workers.emplace_back(work);
+        for(std::thread &w : workers)
+            w.join();
+    }
+
+    double total_time = 0;
+    for(std::size_t k = 0; k != paths.size(); ++k) {
+        std::cout << paths[k] << ":\n" << outputs[k].str();
+        total_time += results[k].time;
+    }
+
+    std::cout << "\nsummary:\n";
+    for(std::size_t k = 0; k != paths.size(); ++k) {
+        const input_result &r = results[k];
+        std::cout << paths[k] << ": " <<
+                     static_cast<long>(r.time * 1000) << " ms, " <<
+                     r.num_sat_solutions << " solutions, " <<
+                     r.num_clauses << " clauses\n";
+    }
+    std::cout << "total: " << paths.size() << " inputs, " <<
+                 static_cast<long>(total_time * 1000) << " ms, " <<
+                 "wall " << static_cast<long>(wall_time * 1000) << " ms, " <<
+                 num_jobs << " jobs\n";
+}
+
+// Times a fixed amount of work similar to that of building
+// nodes, so that times measured on different machines and under
+// different loads can be compared.
+static double measure_calibration_time() {
+    double best = 0;
+    for(int n = 0; n != 5; ++n) {
+        double time = 0;
+        {
+            ::eqbool::timer t(time);
+            std::unordered_map<unsigned, unsigned> m;
+            unsigned x = 1;
+            for(unsigned k = 0; k != 1u << 18; ++k) {
+                x = x * 1103515245u + 12345u;
+                m[x >> 12] += k;
+            }
+            volatile std::size_t sink = m.size();
+            static_cast<void>(sink);
+        }
+        if(n == 0 || time < best)
+            best = time;
+    }
+    return best;
+}
+
+// Performance metrics are identified by the names of the input
+// files and the metric. Limits are relative to baseline values,
+// so a tolerance of 0.1 lets a metric grow by 10%.
+struct baseline_entry {
+    double value = 0;
+    double tolerance = 0;
+};
+
+struct perf_baseline {
+    std::map<std::string, baseline_entry> entries;
+
+    // Only the metrics the baseline has rows for are compared and
+    // updated. Baselines without rows take all of them.
+    std::set<std::string> metrics;
+
+    bool covers(const std::string &metric) const {
+        return metrics.empty() || metrics.count(metric) != 0;
+    }
+};
+
+static void read_baseline(const std::string &path, perf_baseline &baseline) {
+    std::ifstream f(path);
+    if(!f)
+        return;
+
+    std::string line;
+    unsigned line_no = 0;
+    while(std::getline(f, line)) {
+        ++line_no;
+        if(line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream s(line);
+        std::string file, metric;
+        baseline_entry e;
+        if(!(s >> file >> metric >> e.value >> e.tolerance))
+            fatal(path + ": " + std::to_string(line_no) +
+                  ": FILE METRIC VALUE TOLERANCE expected");
+        baseline.entries[file + " " + metric] = e;
+        baseline.metrics.insert(metric);
+    }
+}
+
+static void write_baseline(const std::string &path,
+                           const perf_baseline &baseline) {
+    std::ofstream f(path);
+    f << "# FILE METRIC VALUE TOLERANCE\n";
+    if(baseline.covers("time"))
+        f << "# Times are in units of the calibration time.\n";
+    f << "# Updated with tester --baseline FILE --update-baseline.\n";
+    for(const auto &i : baseline.entries)
+        f << i.first << " " << i.second.value << " " <<
+             i.second.tolerance << "\n";
+    if(!f.flush())
+        fatal("cannot write " + path);
+}
+
+static double get_default_tolerance(const std::string &metric) {
+    // Times are subject to noise, especially on loaded machines.
+    return metric == "time" ? 1.0 : 0.1;
+}
+
+// Returns the number of metrics that regressed.
+static unsigned check_metric(const std::string &key, double value,
+                             const perf_baseline &baseline) {
+    auto i = baseline.entries.find(key);
+    if(i == baseline.entries.end()) {
+        std::cout << key << ": " << value << ", no baseline\n";
+        return 1;
+    }
+
+    const baseline_entry &e = i->second;
+    double limit = e.value * (1 + e.tolerance);
+    bool regressed = value > limit;
+    std::cout << key << ": " << value << ", baseline " << e.value <<
+                 ", limit " << limit << (regressed ? ", regressed" : "") <<
+                 "\n";
+    return regressed ? 1 : 0;
+}
+
+static std::string get_file_name(const std::string &path) {
+    std::size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
 }  // anonymous namespace
 
 int main(int argc, const char **argv) {
-    (void) argc;  // Unused.
-
-    bool find_mismatches = false;
+    test_options opts;
     bool test_performance = false;
+    bool replay_traces = false;
+    bool dimacs_inputs = false;
+    bool captured_inputs = false;
+
+    // Zero means inputs are processed on the main thread.
+    unsigned num_jobs = 0;
+    std::string latency_json_path;
+
+    // Where to compare performance metrics against or to update
+    // them in.
+    std::string baseline_path;
+    bool update_baseline = false;
+
+    bool default_sat_profiles = true;
+    std::vector<std::string> efforts = {"normal"};
     int i = 1;
     for(; argv[i]; ++i) {
         std::string arg = argv[i];
         if(arg == "--find-mismatches") {
-            find_mismatches = true;
+            opts.find_mismatches = true;
             continue;
         }
         if(arg == "--test-performance") {
             test_performance = true;
             continue;
         }
+        if(arg == "--baseline" && argv[i + 1]) {
+            baseline_path = argv[++i];
+            continue;
+        }
+        if(arg == "--update-baseline") {
+            update_baseline = true;
+            continue;
+        }
+        if(arg == "--record" && argv[i + 1]) {
+            opts.record_path = argv[++i];
+            continue;
+        }
+        if(arg == "--latencies") {
+            opts.latencies = true;
+            continue;
+        }
+        if(arg == "--latency-json" && argv[i + 1]) {
+            opts.latencies = true;
+            latency_json_path = argv[++i];
+            continue;
+        }
+        if(arg == "--jobs" && argv[i + 1]) {
+            num_jobs = static_cast<unsigned>(
+                std::strtoul(argv[++i], nullptr, 10));
+            if(num_jobs == 0)
+                num_jobs = std::max(std::thread::hardware_concurrency(), 1u);
+            continue;
+        }
+        if(arg == "--capture-dir" && argv[i + 1]) {
+            opts.capture_dir = argv[++i];
+            continue;
+        }
+        if(arg == "--capture-min-time" && argv[i + 1]) {
+            opts.capture_min_time = std::strtod(argv[++i], nullptr);
+            continue;
+        }
+        if(arg == "--solve-dimacs") {
+            dimacs_inputs = true;
+            continue;
+        }
+        if(arg == "--solve-captured") {
+            dimacs_inputs = true;
+            captured_inputs = true;
+            continue;
+        }
+        if(arg == "--replay") {
+            replay_traces = true;
+            continue;
+        }
+        if(arg == "--small-sat-threshold" && argv[i + 1]) {
+            opts.small_sat_threshold = std::strtoul(argv[++i], nullptr, 10);
+            continue;
+        }
+        if(arg == "--effort" && argv[i + 1]) {
+            // A comma-separated list of levels runs the inputs at
+            // each of them in turn.
+            efforts.clear();
+            std::istringstream s(argv[++i]);
+            std::string name;
+            while(std::getline(s, name, ','))
+                efforts.push_back(name);
+            continue;
+        }
+        if(arg == "--no-xor-reasoning") {
+            opts.xor_reasoning = false;
+            continue;
+        }
+        if(arg == "--max-learned-implications" && argv[i + 1]) {
+            opts.max_learned_implications =
+                std::strtoul(argv[++i], nullptr, 10);
+            continue;
+        }
+        if(arg == "--sat-profile" && argv[i + 1]) {
+            // The first profile specified replaces the default ones.
+            if(default_sat_profiles)
+                opts.sat_profiles.clear();
+            default_sat_profiles = false;
+            opts.sat_profiles.push_back(parse_sat_profile(argv[++i]));
+            continue;
+        }
         break;
     }
 
-    int num_runs = test_performance ? 5 : 1;
+    if(update_baseline && baseline_path.empty())
+        fatal("--update-baseline requires --baseline");
+    if(!baseline_path.empty() && efforts.size() != 1)
+        fatal("--baseline takes a single effort level");
 
-    test_context::total_times_type total_times;
+    // Counters slow down building nodes, so their times are not
+    // comparable with the baselines.
+    perf_baseline baseline;
+    bool compare_times = false;
+    double calibration_time = 0;
+    if(!baseline_path.empty()) {
+        read_baseline(baseline_path, baseline);
+        compare_times = baseline.covers("time") &&
+                        !::eqbool::detail::counters_enabled;
+        if(compare_times)
+            calibration_time = measure_calibration_time();
+    }
+    unsigned num_regressions = 0;
 
-    for(; argv[i]; ++i) {
-        std::string path = argv[i];
-        std::ifstream f(path);
-        if(!f)
-            fatal("cannot open " + path);
-        std::ostringstream input;
-        if(!(input << f.rdbuf()))
-            fatal("cannot read " + path);
+    int num_runs = test_performance || compare_times ? 5 : 1;
 
-        for(int n = 0; n != num_runs; ++n) {
-            if(test_performance) {
-                if(n != 0)
-                    std::cout << "\n";
-                std::cout << "run #" << n + 1 << "\n";
-            }
+    // Every run would overwrite the trace of the previous one.
+    if(!opts.record_path.empty() &&
+           (num_runs != 1 || efforts.size() != 1 || !argv[i] || argv[i + 1]))
+        fatal("--record takes a single input and a single run");
 
-            test_context c(path, total_times, find_mismatches);
-            std::istringstream is(input.str());
-            c.process_test_lines(is);
+    if(dimacs_inputs) {
+        // Without profiles specified, use CaDiCaL defaults.
+        std::vector<::eqbool::sat_profile> profiles = opts.sat_profiles;
+        if(default_sat_profiles) {
+            profiles.assign(1, ::eqbool::sat_profile());
+            profiles[0].name = "default";
         }
+        for(int k = i; argv[k]; ++k) {
+            if(captured_inputs)
+                solve_captured(argv[k], profiles);
+            else
+                solve_dimacs(argv[k], profiles);
+        }
+        return EXIT_SUCCESS;
     }
 
-    if(test_performance) {
-        std::cout << "\nmedian times:\n";
-        for(auto &t : total_times) {
-            std::vector<test_context::time_and_stats_type> &v = t.second;
-            std::sort(v.begin(), v.end());
-            std::cout << "median: " << v[v.size() / 2].second;
+    if(replay_traces) {
+        for(const std::string &effort : efforts) {
+            opts.effort = parse_effort(effort);
+            for(int k = i; argv[k]; ++k)
+                replay(argv[k], opts);
         }
+        return EXIT_SUCCESS;
     }
+
+    // Latencies of the last run of every input at every effort
+    // level.
+    std::ostringstream latency_json;
+
+    std::vector<std::string> paths(argv + i, argv + argc);
+
+    for(const std::string &effort : efforts) {
+        opts.effort = parse_effort(effort);
+        if(efforts.size() > 1)
+            std::cout << "effort " << effort << ":\n";
+
+        run_options run_opts;
+        run_opts.test = opts;
+        run_opts.effort = effort;
+        run_opts.num_runs = num_runs;
+        run_opts.test_performance = test_performance;
+        run_opts.latency_json = !latency_json_path.empty();
+
+        std::vector<input_result> results;
+        if(num_jobs != 0) {
+            run_inputs_in_parallel(paths, run_opts, num_jobs, results);
+        } else {
+            results.resize(paths.size());
+            for(std::size_t k = 0; k != paths.size(); ++k)
+                run_input(paths[k], run_opts, std::cout, results[k]);
+        }
+
+        // Medians are taken across the inputs, by line numbers.
+        test_context::total_times_type total_times;
+        for(input_result &r : results) {
+            for(auto &t : r.total_times) {
+                auto &v = total_times[t.first];
+                v.insert(v.end(), t.second.begin(), t.second.end());
+            }
+            if(!r.latency_json.empty()) {
+                latency_json << (latency_json.tellp() == 0 ? "" : ",") <<
+                                "\n  " << r.latency_json;
+            }
+        }
+
+        if(test_performance) {
+            std::cout << "\nmedian times:\n";
+            for(auto &t : total_times) {
+                std::vector<test_context::time_and_stats_type> &v = t.second;
+                std::sort(v.begin(), v.end());
+                std::cout << "median: " << v[v.size() / 2].second;
+            }
+        }
+
+        if(!baseline_path.empty()) {
+            std::cout << "\nbaseline:\n";
+            for(std::size_t k = 0; k != paths.size(); ++k) {
+                input_result &r = results[k];
+                std::sort(r.times.begin(), r.times.end());
+                const std::pair<const char*, double> metrics[] = {
+                    {"solutions", static_cast<double>(r.num_sat_solutions)},
+                    {"clauses", static_cast<double>(r.num_clauses)},
+                    {"nodes", static_cast<double>(r.num_nodes)},
+                    {"time", compare_times ?
+                         r.times[r.times.size() / 2] / calibration_time : 0}};
+                std::string file = get_file_name(paths[k]);
+                for(const auto &m : metrics) {
+                    if(!baseline.covers(m.first) ||
+                           (std::strcmp(m.first, "time") == 0 &&
+                            !compare_times))
+                        continue;
+
+                    std::string key = file + " " + m.first;
+                    if(update_baseline) {
+                        // Keep the tolerances of the known metrics.
+                        auto e = baseline.entries.insert(
+                            {key, baseline_entry()});
+                        if(e.second) {
+                            e.first->second.tolerance =
+                                get_default_tolerance(m.first);
+                        }
+                        e.first->second.value = m.second;
+                        continue;
+                    }
+                    num_regressions += check_metric(key, m.second, baseline);
+                }
+            }
+        }
+    }
+
+    if(update_baseline)
+        write_baseline(baseline_path, baseline);
+
+    if(!latency_json_path.empty()) {
+        std::ofstream f(latency_json_path);
+        if(!(f << "[" << latency_json.str() << "\n]\n"))
+            fatal("cannot write " + latency_json_path);
+    }
+
+    if(num_regressions != 0)
+        fatal("regressed metrics: " + std::to_string(num_regressions));
 }